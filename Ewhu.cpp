@@ -1,11 +1,17 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <algorithm>
+#include <iomanip>
 
 #include "lexer/lexer.h"
+#include "lexer/scan.h"
 #include "parser/parser.h"
 #include "evaluator/evaluator.h"
+#include "vm/vm.h"
+#include "closure/closure.h"
 
 #include "rapidjson/include/rapidjson/document.h"
 #include "rapidjson/include/rapidjson/writer.h"
@@ -17,18 +23,36 @@ namespace hl
 #include <windows.h>
 #include <conio.h>
 }
+#else
+#include <sys/resource.h>
 #endif
 
 class Ewhu
 {
 public:
+    // 执行后端
+    enum Backend
+    {
+        BACKEND_AST = 0, // 树遍历求值（参考实现）
+        BACKEND_VM,      // 字节码虚拟机
+        BACKEND_CLOSURE, // 闭包编译
+    };
+    inline static Backend backend = BACKEND_AST;
+    inline static long long parse_ns = 0;   // -b 时累计的语法分析耗时
+    inline static long long lex_ns = 0;     // -b 时累计的词法分析耗时
+    inline static long long lex_bytes = 0;  // -b 时累计扫描的字节数
+    inline static long long lex_tokens = 0; // -b 时累计生成的 Token 数
+
     inline static void printUsage()
     {
         std::cerr << "\033[34m";
         std::cerr << "Run Prompt Usage: Ewhu" << std::endl;
         std::cerr << "Run File Usage: Ewhu [script]" << std::endl;
         std::cerr << "Bench Prompt Usage: Ewhu -b" << std::endl;
-        std::cerr << "Bench File Usage: Ewhu -b [script]" << "\033[0m" << std::endl;
+        std::cerr << "Bench File Usage: Ewhu -b [script]" << std::endl;
+        std::cerr << "Bytecode VM: Ewhu -vm [-b] [script]" << std::endl;
+        std::cerr << "Closure Compilation: Ewhu -cl [-b] [script]" << std::endl;
+        std::cerr << "Cycle Collection: Ewhu -gc[=threshold] [script]" << "\033[0m" << std::endl;
     }
     template <typename... Msgs>
     inline static void printError(const Msgs &...msgs)
@@ -49,7 +73,7 @@ public:
     }
 
     template <typename T>
-    inline static void bench(T Function, int times = 10000)
+    inline static long long bench(T Function, int times = 10000, bool report = true)
     {
         auto start = std::chrono::high_resolution_clock::now();
         for (int i = 0; i < times; i++)
@@ -58,43 +82,120 @@ public:
         }
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        std::cout << "run time: " << duration.count() << "ms" << std::endl;
+        if (report)
+            std::cout << "run time: " << duration.count() << "ms" << std::endl;
+        return duration.count();
     }
 
-public:
-    static void runFile(const std::string &path)
+    // 按所选后端执行程序
+    static Value execute(const std::shared_ptr<Program> &program, Evaluator &evaluator, Scope &global_scp)
     {
-        std::string line;
-        std::vector<Token> tokens;
-        Lexer lexer;
-        Parser parser;
-        Evaluator evaluator;
+        if (backend == BACKEND_VM)
+        {
+            static VM vm;
+            return vm.run_program(program, global_scp);
+        }
+        if (backend == BACKEND_CLOSURE)
+        {
+            static ClosureCompiler closure;
+            return closure.run_program(program, global_scp);
+        }
+        return evaluator.eval_program(program, global_scp);
+    }
 
-        std::ifstream file(path);
+    // 一次读入整个文件
+    static std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
         if (!file.is_open())
         {
             printError("Error: Could not open file " + path);
             exit(1);
         }
-        int lineNum = 1;
-        while (std::getline(file, line))
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file ? (std::streamoff)file.tellg() : -1;
+        std::string source;
+        if (size < 0 || (unsigned long long)size > source.max_size()) // 不能定位（如管道）或不是普通文件（如目录）
         {
-            lineNum++;
-            if (!line.empty())
+            printError("Error: Could not read file " + path);
+            exit(1);
+        }
+        source.resize(size);
+        file.seekg(0, std::ios::beg);
+        if (!file.read(source.data(), source.size()))
+        {
+            printError("Error: Could not read file " + path);
+            exit(1);
+        }
+        return source;
+    }
+
+    // 源码中第 line 行的内容，lineStarts 为空时先建立各行起点的索引
+    static std::string_view sourceLine(std::string_view source, std::vector<size_t> &lineStarts, int line)
+    {
+        if (lineStarts.empty())
+        {
+            lineStarts.push_back(0);
+            for (size_t i = source.find('\n'); i != std::string_view::npos; i = source.find('\n', i + 1))
+                lineStarts.push_back(i + 1);
+        }
+        if (line < 1 || line > (int)lineStarts.size())
+            return {};
+        size_t begin = lineStarts[line - 1];
+        auto text = source.substr(begin, source.find('\n', begin) - begin);
+        if (!text.empty() && text.back() == '\r')
+            text.remove_suffix(1);
+        return text;
+    }
+
+    // 一次扫描整个文件，再逐条顶层语句交给 handle 执行；出错时报告所在的行并继续
+    template <typename T>
+    static void runSource(const std::string &source, Lexer &lexer, T handle)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        lexer.scanSource(source);
+        lex_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        lex_bytes += source.size();
+        lex_tokens += lexer.tokens.size();
+
+        auto &tokens = lexer.tokens;
+        auto &ends = lexer.statementEnds;
+        std::vector<size_t> lineStarts; // 出错时才建立
+        size_t begin = 0, error = 0;
+        for (size_t i = 0; i <= ends.size(); i++)
+        {
+            for (; error < lexer.errors.size() && lexer.errors[error].statement == i; error++)
             {
-                try
-                {
-                    run(line, tokens, lexer, parser, evaluator);
-                }
-                catch (const std::exception &e)
-                {
-                    tokens.clear();
-                    printError(lineNum, ": ", line);
-                    printError(e.what());
-                }
+                auto &e = lexer.errors[error];
+                printError(e.line, ": ", sourceLine(source, lineStarts, e.line));
+                printError(e.message);
+            }
+            if (i == ends.size())
+                break;
+            try
+            {
+                handle(tokens.begin() + begin, tokens.begin() + ends[i]);
+            }
+            catch (const std::exception &e)
+            {
+                int line = tokens[ends[i] - 1].line;
+                printError(line, ": ", sourceLine(source, lineStarts, line));
+                printError(e.what());
             }
+            begin = ends[i];
         }
-        file.close();
+    }
+
+public:
+    static void runFile(const std::string &path)
+    {
+        std::string source = readFile(path);
+        Lexer lexer;
+        Parser parser;
+        Evaluator evaluator;
+
+        runSource(source, lexer, [&](auto begin, auto end)
+                  { runStatement(begin, end, parser, evaluator); });
     }
 
     static void runPrompt()
@@ -130,27 +231,88 @@ public:
         }
     }
 
+    // 进程的峰值内存（KB），不支持的平台返回 -1
+    static long peakRSS()
+    {
+#ifdef _WIN32
+        return -1;
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    }
+
     static void runBenchFile(const std::string &path)
     {
-        std::string line;
-        std::vector<Token> tokens;
-        Lexer lexer;
-        Parser parser;
-        Evaluator evaluator;
+        parse_ns = 0;
+        lex_ns = 0;
+        lex_bytes = 0;
+        lex_tokens = 0;
+#ifdef EWHU_REFCOUNT_STATS
+        long long retains = RefCounted::retains, releases = RefCounted::releases;
+#endif
+        long long allocations = Pool::allocations();
+        long long elapsed = benchFile(path, true);
+        std::cout << "[bench] lex: " << lex_ns / 1000000 << "ms (" << std::fixed << std::setprecision(2)
+                  << lex_bytes * 1000.0 / std::max(lex_ns, 1LL) << " MB/s, " << lex_tokens << " tokens of "
+                  << sizeof(Token) << " bytes)" << std::endl;
+        std::cout << "[bench] lex scan: " << Scan::mode() << std::endl;
+        std::cout << "[bench] parse: " << parse_ns / 1000000 << "ms" << std::endl;
+#ifdef EWHU_ATOMIC_REFCOUNT
+        std::cout << "[bench] refcount (atomic): ";
+#else
+        std::cout << "[bench] refcount (non-atomic): ";
+#endif
+#ifdef EWHU_REFCOUNT_STATS
+        std::cout << RefCounted::retains - retains << " retains, " << RefCounted::releases - releases << " releases" << std::endl;
+#else
+        std::cout << "not counted (build with EWHU_REFCOUNT_STATS)" << std::endl;
+#endif
+        std::cout << "[bench] object allocations: " << Pool::allocations() - allocations << std::endl;
+        if (peakRSS() >= 0)
+            std::cout << "[bench] peak rss: " << peakRSS() << "KB" << std::endl;
+        if (Collector::enabled())
+            std::cout << "[bench] gc: " << Collector::report() << std::endl;
+        if (backend == BACKEND_AST)
+            return;
 
-        std::ifstream file(path);
-        if (!file.is_open())
+        // 再用树遍历求值跑一遍（不输出，错误也已在上面报告过）作为对照
+        Backend selected = backend;
+        backend = BACKEND_AST;
+        auto *out = std::cout.rdbuf(nullptr);
+        auto *err = std::cerr.rdbuf(nullptr);
+        long long reference = benchFile(path, false);
+        std::cout.rdbuf(out);
+        std::cout.clear();
+        std::cerr.rdbuf(err);
+        std::cerr.clear();
+        backend = selected;
+        std::cout << "speedup over tree-walking: " << std::fixed << std::setprecision(2) << (double)reference / std::max(elapsed, 1LL)
+                  << "x (" << reference << "ms)" << std::endl;
+        if (backend == BACKEND_VM)
         {
-            printError("Error: Could not open file " + path);
-            exit(1);
+            std::cout << "[bench] vm dispatch: " << VM::dispatch_mode() << std::endl;
+            std::cout << "[bench] vm superinstructions: " << VM::fused_report() << std::endl;
         }
-        std::vector<char> buffer(1024 * 1024);
-        file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    }
 
-        bench([&]()
-              {while (std::getline(file, line)){onlyRun(line, tokens, lexer, parser, evaluator);} });
+    static long long benchFile(const std::string &path, bool report)
+    {
+        std::string source = readFile(path);
+        Lexer lexer;
+        Parser parser;
+        Evaluator evaluator;
+        Scope global_scp;
 
-        file.close();
+        long long elapsed = bench([&]()
+                                  { runSource(source, lexer, [&](auto begin, auto end)
+                                              { onlyRun(begin, end, parser, evaluator, global_scp); }); }, 1, report);
+        return elapsed;
     }
 
     static void runBenchPrompt()
@@ -175,22 +337,14 @@ public:
     }
 
     // 不做检查和输出，只运行
-    static void onlyRun(const std::string &source, std::vector<Token> &tokens, Lexer &lexer,
-                        Parser &parser, Evaluator &evaluator)
+    static void onlyRun(std::vector<Token>::iterator begin, std::vector<Token>::iterator end,
+                        Parser &parser, Evaluator &evaluator, Scope &global_scp)
     {
-        std::vector<Token> new_tokens = lexer.scanTokens(source);
-        tokens.insert(tokens.end(), new_tokens.begin(), new_tokens.end());
-
-        if ((lexer.braceStatus == 0) &&
-            ((--tokens.end())->type == TokenType::SEMICOLON ||
-             (--tokens.end())->type == TokenType::RIGHT_BRACE))
-        {
-            parser.parse_program(tokens);
-            tokens.clear();
-            auto program = parser.m_program;
-            static Scope global_scp;
-            auto evaluated = evaluator.eval_program(program, global_scp);
-        }
+        auto start = std::chrono::high_resolution_clock::now();
+        parser.parse_program(begin, end);
+        parse_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        auto program = parser.m_program;
+        auto evaluated = execute(program, evaluator, global_scp);
     }
 
     // 对每个模块进行测试
@@ -201,7 +355,7 @@ public:
             [&]()
             {
                 tokens.clear();
-                std::vector<Token> new_tokens = lexer.scanTokens(source);
+                auto &new_tokens = lexer.scanTokens(source);
                 tokens.insert(tokens.end(), new_tokens.begin(), new_tokens.end());
             });
 
@@ -219,9 +373,9 @@ public:
                 [&]()
                 {
                     static Scope global_scp;
-                    auto evaluated = evaluator.eval_program(parser.m_program, global_scp);
+                    auto evaluated = execute(parser.m_program, evaluator, global_scp);
                     if (evaluated)
-                        std::cout << evaluated->str() << std::endl;
+                        std::cout << evaluated.str() << std::endl;
                 });
         }
     }
@@ -230,27 +384,33 @@ public:
     static void run(const std::string &source, std::vector<Token> &tokens, Lexer &lexer,
                     Parser &parser, Evaluator &evaluator)
     {
-        lexer.scanTokens(source);
-        std::vector<Token> new_tokens = lexer.scanTokens(source);
+        auto &new_tokens = lexer.scanTokens(source);
         tokens.insert(tokens.end(), new_tokens.begin(), new_tokens.end());
 
         if ((lexer.braceStatus == 0) &&
             ((--tokens.end())->type == TokenType::SEMICOLON ||
              (--tokens.end())->type == TokenType::RIGHT_BRACE))
         {
-            parser.parse_program(tokens);
+            runStatement(tokens.begin(), tokens.end(), parser, evaluator);
             tokens.clear();
+        }
+    }
+
+    // 执行一条完整的顶层语句
+    static void runStatement(std::vector<Token>::iterator begin, std::vector<Token>::iterator end,
+                             Parser &parser, Evaluator &evaluator)
+    {
+        parser.parse_program(begin, end);
 
-            auto &program = parser.m_program;
-            program->jsonOutput();
-            printGreen("AST output to ast.json");
+        auto &program = parser.m_program;
+        program->jsonOutput();
+        printGreen("AST output to ast.json");
 
-            printGreen("evaluatingヾ(✿ﾟ▽ﾟ)ノ");
-            static Scope global_scp;
-            auto evaluated = evaluator.eval_program(program, global_scp);
-            if (evaluated)
-                std::cout << evaluated->str() << std::endl;
-        }
+        printGreen("evaluatingヾ(✿ﾟ▽ﾟ)ノ");
+        static Scope global_scp;
+        auto evaluated = execute(program, evaluator, global_scp);
+        if (evaluated)
+            std::cout << evaluated.str() << std::endl;
     }
 };
 
@@ -263,25 +423,38 @@ int main(int argc, char *argv[])
 #endif
 
     Ewhu::printBlue("Ewhu Programming Language Ciallo～(∠・ω< )⌒★");
-    if (argc > 3)
-    {
-        Ewhu::printError("Error: Too many arguments");
-        Ewhu::printUsage();
-        exit(64);
-    }
-    else if (argc == 3)
-    {
-        if (std::string(argv[1]) == "-b")
-            Ewhu::runBenchFile(argv[2]); // 进入脚本测试模式
-    }
-    else if (argc == 2)
+    bool bench = false;
+    std::string script;
+    for (int i = 1; i < argc; i++)
     {
-        if (std::string(argv[1]) == "-b")
-            Ewhu::runBenchPrompt(); // 进入交互测试模式
+        std::string arg(argv[i]);
+        if (arg == "-b")
+            bench = true;
+        else if (arg == "-vm")
+            Ewhu::backend = Ewhu::BACKEND_VM;
+        else if (arg == "-cl")
+            Ewhu::backend = Ewhu::BACKEND_CLOSURE;
+        else if (arg == "-gc")
+            Collector::enable();
+        else if (arg.rfind("-gc=", 0) == 0)
+            Collector::enable(std::max(1LL, std::atoll(arg.c_str() + 4)));
+        else if (script.empty())
+            script = arg;
         else
-            Ewhu::runFile(argv[1]); // 进入脚本模式
+        {
+            Ewhu::printError("Error: Too many arguments");
+            Ewhu::printUsage();
+            exit(64);
+        }
     }
-    else if (argc == 1)
+
+    if (bench && !script.empty())
+        Ewhu::runBenchFile(script); // 进入脚本测试模式
+    else if (bench)
+        Ewhu::runBenchPrompt(); // 进入交互测试模式
+    else if (!script.empty())
+        Ewhu::runFile(script); // 进入脚本模式
+    else
         Ewhu::runPrompt(); // 进入交互模式
     return 0;
 }
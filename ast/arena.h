@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <new>
+#include "node.h"
+
+// 语法树节点的分配区：节点依次分配在大块内存中，随分配区一起析构和释放
+//
+// make 返回不持有所有权的 NodeRef，节点之间也都用 NodeRef 相连；
+// 节点需要比所属的程序活得更久时（如登记到作用域中的函数），用 retain 换成持有分配区的 std::shared_ptr。
+class Arena : public std::enable_shared_from_this<Arena>
+{
+public:
+    Arena() {}
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena()
+    {
+        for (auto it = m_nodes.rbegin(); it != m_nodes.rend(); ++it)
+            (*it)->~Node();
+    }
+
+    template <typename T>
+    NodeRef<T> make()
+    {
+        T *node = new (allocate(sizeof(T), alignof(T))) T();
+        m_nodes.push_back(node);
+        return NodeRef<T>(node);
+    }
+
+    std::shared_ptr<Node> retain(Node *node) { return std::shared_ptr<Node>(shared_from_this(), node); }
+
+private:
+    void *allocate(size_t size, size_t align)
+    {
+        size_t offset = (m_used + align - 1) & ~(align - 1);
+        if (m_blocks.empty() || offset + size > BLOCK_SIZE)
+        {
+            m_blocks.emplace_back(new char[BLOCK_SIZE]);
+            offset = 0;
+        }
+        m_used = offset + size;
+        return m_blocks.back().get() + offset;
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024; // 远大于任何节点
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    size_t m_used = 0;          // 最后一块已用的字节数
+    std::vector<Node *> m_nodes; // 按分配顺序记录，析构时逆序调用析构函数
+};
@@ -13,7 +13,7 @@ public:
         std::string *typeStr = new std::string;
         *typeStr = name();
         std::string *valueStr = new std::string;
-        *valueStr = m_name;
+        *valueStr = Intern::name(m_name);
         str_vector.push_back(typeStr);
         str_vector.push_back(valueStr);
         json.AddMember("type", rapidjson::StringRef(typeStr->c_str()), father.GetAllocator());
@@ -70,6 +70,30 @@ public:
 public:
 };
 
+class Fraction : public Expression
+{
+public:
+    Fraction() : Expression(Type::NODE_FRACTION) {}
+    ~Fraction() {};
+
+    virtual rapidjson::Value json(rapidjson::Document &father)
+    {
+        rapidjson::Value json(rapidjson::kObjectType);
+        std::string *typeStr = new std::string;
+        *typeStr = name();
+        std::string *valueStr = new std::string;
+        *valueStr = std::to_string(m_value) + "/" + std::to_string(m_den);
+        str_vector.push_back(typeStr);
+        str_vector.push_back(valueStr);
+        json.AddMember("type", rapidjson::StringRef(typeStr->c_str()), father.GetAllocator());
+        json.AddMember("value", rapidjson::StringRef(valueStr->c_str()), father.GetAllocator());
+        return json;
+    }
+
+public:
+    long long m_den = 1;
+};
+
 class String : public Expression
 {
 public:
@@ -91,6 +115,7 @@ public:
     }
 
 public:
+    std::string m_string;
 };
 
 class Infix : public Expression // 中缀表达式
@@ -174,7 +199,7 @@ public:
         std::string *typeStr = new std::string;
         *typeStr = name();
         std::string *valueStr = new std::string;
-        *valueStr = m_name;
+        *valueStr = Intern::name(m_name);
         str_vector.push_back(typeStr);
         str_vector.push_back(valueStr);
         rapidjson::Value args(rapidjson::kArrayType);
@@ -189,6 +214,12 @@ public:
     }
 
 public:
+    std::vector<NodeRef<Node>> m_initial_list;
+    // 调用点缓存：m_call_epoch 与 Scope::function_epoch(m_name) 相同时有效。
+    // m_callee 指向作用域函数表中 retain 得到的指针，表项持有函数所在的分配区，所以缓存有效时节点一定还在
+    const std::shared_ptr<Node> *m_callee = nullptr; // 解析到的用户函数（作用域中的表项），为空时是内置函数
+    int m_builtin = -1;                              // 解析到的内置函数
+    long long m_call_epoch = -1;
 };
 
 class Array : public Expression // 数组
@@ -216,5 +247,5 @@ public:
     }
 
 public:
-    std::vector<std::shared_ptr<Expression>> m_array;
+    std::vector<NodeRef<Expression>> m_array;
 };
\ No newline at end of file
@@ -19,6 +19,7 @@ std::unordered_map<Node::Type, std::string> Node::m_names = {
     {Node::NODE_FUNCTION_IDENTIFIER, "FunctionIdentifier"},
     {Node::NODE_RETURNSTATEMENT, "ReturnStatement"},
     {Node::NODE_ARRAY, "Array"},
+    {Node::NODE_FRACTION, "Fraction"},
 };
 
 std::vector<std::string *> Node::str_vector = std::vector<std::string *>();
@@ -4,10 +4,12 @@
 #include <iostream>
 #include <string>
 #include "../lexer/token.h"
+#include "../lexer/intern.h"
 #include "../rapidjson/include/rapidjson/document.h"
 #include "../rapidjson/include/rapidjson/writer.h"
 #include "../rapidjson/include/rapidjson/stringbuffer.h"
 #include "../object/object.h"
+#include "noderef.h"
 #include <vector>
 
 class Identifier;
@@ -42,6 +44,7 @@ public:
         NODE_FUNCTION_IDENTIFIER, // 调用
         NODE_RETURNSTATEMENT,     // 函数返回
         NODE_ARRAY,               // 数组
+        NODE_FRACTION,            // 分数常量（常量折叠的结果）
     };
 
     Node() {}
@@ -65,41 +68,33 @@ public:
     static std::vector<std::string *> str_vector;
 
 public:
-    Type m_type;
-    Token m_token;
     static std::unordered_map<Type, std::string> m_names;
 
-public:
-    std::vector<std::shared_ptr<Node>> m_statements;
-
-    std::shared_ptr<Identifier> m_func;
-    std::shared_ptr<StatementBlock> m_statement;
-    std::vector<std::shared_ptr<Node>> m_initial_list;
-
-    // re std::vector<std::shared_ptr<Statement>> m_statements;
-    std::vector<std::shared_ptr<Function>> m_functions;
-
-    std::shared_ptr<Expression> m_expression;
-
-    // std::shared_ptr<Expression> m_expression;
-    std::shared_ptr<Statement> m_true_statement;
-    // std::shared_ptr<Statement> m_false_statement;
-    std::shared_ptr<Statement> m_false_statement;
-
-    // std::shared_ptr<Expression> m_expression;
-    std::shared_ptr<Statement> m_cycle_statement;
-    // std::shared_ptr<Statement> m_false_statement;
-
-    std::shared_ptr<ExpressionStatement> m_expression_statement;
+    // 各类节点特有的字段放在子类中，以下访问函数定义在 statement.h
+    std::vector<NodeRef<Node>> &statements();             // Program、StatementBlock
+    std::vector<int> &locals();                           // 语句块/函数作用域的槽位布局（槽位 -> 名字）
+    std::vector<NodeRef<Node>> &initial_list();           // Function 的形参、FunctionIdentifier 的实参
+    NodeRef<Expression> &expression();                    // ExpressionStatement、IfStatement、WhileStatement
+    NodeRef<Statement> &true_statement();                 // IfStatement
+    NodeRef<Statement> &false_statement();                // IfStatement
+    NodeRef<Statement> &cycle_statement();                // WhileStatement
+    NodeRef<ExpressionStatement> &expression_statement(); // ReturnStatement
+    NodeRef<Identifier> &func();                          // Function 的函数名
+    NodeRef<StatementBlock> &statement();                 // Function 的函数体
+    std::string &string();                                // String
+    long long &den();                                     // Fraction 的分母，分子为 m_value
 
+public:
+    // 所有节点共有的字段，按大小排列以减少填充
+    Type m_type;
+    TokenType m_operator; // 运算符
     int m_name = 0;
-    long long m_value = 0;
+    int m_depth = -1; // 解析结果：变量所在作用域距当前作用域的层数
+    int m_slot = -1;  // 解析结果：变量在该作用域中的槽位，-1 表示按名字查找
     bool m_bool = false;
-    std::string m_string = "";
-
-    TokenType m_operator;                // 运算符
-    std::shared_ptr<Expression> m_left;  // 左表达式
-    std::shared_ptr<Expression> m_right; // 右表达式
+    long long m_value = 0;
+    NodeRef<Expression> m_left;  // 左表达式
+    NodeRef<Expression> m_right; // 右表达式
 };
 
 class Expression : public Node
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// 指向语法树节点的指针，不持有所有权：节点分配在程序的分配区中（见 arena.h），随分配区一起释放。
+// 只有需要让节点比所属程序活得更久的地方（如作用域中登记的函数）才用 Arena::retain 得到的 std::shared_ptr。
+template <typename T>
+class NodeRef
+{
+public:
+    NodeRef() = default;
+    NodeRef(std::nullptr_t) {}
+    explicit NodeRef(T *ptr) : m_ptr(ptr) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value>>
+    NodeRef(const NodeRef<U> &other) : m_ptr(other.get()) {}
+
+    // 持有所有权的指针可以直接当作节点使用（在它的生命周期内）
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value>>
+    NodeRef(const std::shared_ptr<U> &other) : m_ptr(other.get()) {}
+
+    T *get() const { return m_ptr; }
+    T *operator->() const { return m_ptr; }
+    T &operator*() const { return *m_ptr; }
+    explicit operator bool() const { return m_ptr != nullptr; }
+
+    friend bool operator==(const NodeRef &lhs, const NodeRef &rhs) { return lhs.m_ptr == rhs.m_ptr; }
+    friend bool operator!=(const NodeRef &lhs, const NodeRef &rhs) { return lhs.m_ptr != rhs.m_ptr; }
+
+private:
+    T *m_ptr = nullptr;
+};
+
+template <typename T, typename U>
+NodeRef<T> static_node_cast(const NodeRef<U> &ref) { return NodeRef<T>(static_cast<T *>(ref.get())); }
+
+template <typename T, typename U>
+NodeRef<T> dynamic_node_cast(const NodeRef<U> &ref) { return NodeRef<T>(dynamic_cast<T *>(ref.get())); }
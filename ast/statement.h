@@ -1,8 +1,12 @@
 #pragma once
 #include "node.h"
 #include "infix.h"
+#include "arena.h"
 #include <fstream>
 
+class Chunk;             // 虚拟机编译出的字节码
+struct CompiledFunction; // 闭包编译出的函数体
+
 class StatementBlock : public Statement
 {
 public:
@@ -26,6 +30,11 @@ public:
     }
 
 public:
+    std::vector<NodeRef<Node>> m_statements;
+    std::vector<int> m_locals; // 作用域的槽位布局
+
+protected:
+    StatementBlock(Type type) : Statement(type) {}
 };
 
 class Function : public Statement // 函数的声明
@@ -54,13 +63,28 @@ public:
         return json;
     }
 
+    // 登记到作用域时调用：换成持有分配区的指针，函数可以比声明它的程序（如 eval 中的）活得更久
+    static std::shared_ptr<Node> retain(const NodeRef<Node> &function)
+    {
+        return static_cast<Function *>(function.get())->m_arena->retain(function.get());
+    }
+
 public:
+    NodeRef<Identifier> m_func;
+    NodeRef<StatementBlock> m_statement;
+    std::vector<NodeRef<Node>> m_initial_list;
+    std::vector<int> m_locals; // 函数作用域的槽位布局
+    Arena *m_arena = nullptr;  // 节点所在的分配区
+
+    // 各后端编译出的函数体，和节点一起随分配区释放；其中引用的节点与本节点同属一个分配区，不需要持有它
+    std::shared_ptr<Chunk> m_chunk;
+    std::shared_ptr<CompiledFunction> m_compiled;
 };
 
-class Program : public Statement // 根节点
+class Program : public StatementBlock // 根节点
 {
 public:
-    Program() : Statement(Type::NODE_PROGRAM) {}
+    Program() : StatementBlock(Type::NODE_PROGRAM) {}
     ~Program() {}
 
     virtual rapidjson::Value json(rapidjson::Document &father)
@@ -103,8 +127,8 @@ public:
     }
 
 public:
-    std::unordered_map<int, std::string> *identifier_map; // 标识符反映射
-    std::unordered_map<int, std::string> *function_map;   // 函数反映射
+    std::shared_ptr<Arena> m_arena = std::make_shared<Arena>(); // 程序中除根节点外的所有节点
+    std::vector<NodeRef<Function>> m_functions;
 };
 
 class ExpressionStatement : public Statement
@@ -125,6 +149,7 @@ public:
     }
 
 public:
+    NodeRef<Expression> m_expression;
 };
 
 class IfStatement : public Statement
@@ -151,6 +176,9 @@ public:
     }
 
 public:
+    NodeRef<Expression> m_expression;
+    NodeRef<Statement> m_true_statement;
+    NodeRef<Statement> m_false_statement;
 };
 
 class WhileStatement : public Statement
@@ -172,6 +200,8 @@ public:
     }
 
 public:
+    NodeRef<Expression> m_expression;
+    NodeRef<Statement> m_cycle_statement;
 };
 
 class BreakStatement : public Statement
@@ -223,4 +253,43 @@ public:
     }
 
 public:
-};
\ No newline at end of file
+    NodeRef<ExpressionStatement> m_expression_statement;
+};
+
+inline std::vector<NodeRef<Node>> &Node::statements() { return static_cast<StatementBlock *>(this)->m_statements; }
+
+inline std::vector<int> &Node::locals()
+{
+    if (m_type == NODE_FUNCTION)
+        return static_cast<Function *>(this)->m_locals;
+    return static_cast<StatementBlock *>(this)->m_locals;
+}
+
+inline std::vector<NodeRef<Node>> &Node::initial_list()
+{
+    if (m_type == NODE_FUNCTION)
+        return static_cast<Function *>(this)->m_initial_list;
+    return static_cast<FunctionIdentifier *>(this)->m_initial_list;
+}
+
+inline NodeRef<Expression> &Node::expression()
+{
+    switch (m_type)
+    {
+    case NODE_IFSTATEMENT:
+        return static_cast<IfStatement *>(this)->m_expression;
+    case NODE_WHILESTATEMENT:
+        return static_cast<WhileStatement *>(this)->m_expression;
+    default:
+        return static_cast<ExpressionStatement *>(this)->m_expression;
+    }
+}
+
+inline NodeRef<Statement> &Node::true_statement() { return static_cast<IfStatement *>(this)->m_true_statement; }
+inline NodeRef<Statement> &Node::false_statement() { return static_cast<IfStatement *>(this)->m_false_statement; }
+inline NodeRef<Statement> &Node::cycle_statement() { return static_cast<WhileStatement *>(this)->m_cycle_statement; }
+inline NodeRef<ExpressionStatement> &Node::expression_statement() { return static_cast<ReturnStatement *>(this)->m_expression_statement; }
+inline NodeRef<Identifier> &Node::func() { return static_cast<Function *>(this)->m_func; }
+inline NodeRef<StatementBlock> &Node::statement() { return static_cast<Function *>(this)->m_statement; }
+inline std::string &Node::string() { return static_cast<String *>(this)->m_string; }
+inline long long &Node::den() { return static_cast<Fraction *>(this)->m_den; }
\ No newline at end of file
@@ -0,0 +1,656 @@
+#include "closure.h"
+#include "../parser/parser.h"
+
+ClosureCompiler::ClosureCompiler()
+    : m_break(make_object<Ob_Break>()), m_continue(make_object<Ob_Continue>()),
+      m_return(make_object<Ob_Return>(Value())), m_tail(make_object<Ob_Return>(Value()))
+{
+}
+
+Value ClosureCompiler::run_program(const std::shared_ptr<Program> &program, Scope &global_scp)
+{
+    if (program->statements().empty())
+        throw std::runtime_error("ClosureCompiler::run_program: empty program");
+    m_folder.fold_program(program, m_evaluator);
+    m_resolver.resolve_program(program, global_scp);
+    auto thunk = compile(*(--program->statements().end()));
+    m_tail_args.clear(); // 上次出错时可能留下未取走的实参
+    return thunk(global_scp);
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile(const NodeRef<Node> &node)
+{
+    switch (node->type())
+    {
+    case Node::NODE_STATEMENTBLOCK:
+    {
+        return compile_block(node);
+    }
+    case Node::NODE_IFSTATEMENT:
+    {
+        auto condition = compile(node->expression());
+        auto true_statement = compile(node->true_statement());
+        if (!node->false_statement())
+        {
+            return [condition, true_statement](Scope &scp) -> Value
+            {
+                if (condition(scp).m_int)
+                    return true_statement(scp);
+                return nullptr;
+            };
+        }
+        auto false_statement = compile(node->false_statement());
+        return [condition, true_statement, false_statement](Scope &scp) -> Value
+        {
+            if (condition(scp).m_int)
+                return true_statement(scp);
+            return false_statement(scp);
+        };
+    }
+    case Node::NODE_WHILESTATEMENT:
+    {
+        return compile_while(node);
+    }
+    case Node::NODE_EXPRESSION_STATEMENT:
+    {
+        return compile(node->expression());
+    }
+    case Node::NODE_IDENTIFIER:
+    {
+        return compile_identifier(node);
+    }
+    case Node::NODE_BOOLEAN:
+    case Node::NODE_INTEGER:
+    case Node::NODE_STRING:
+    case Node::NODE_FRACTION:
+    {
+        Value constant;
+        if (node->type() == Node::NODE_BOOLEAN)
+            constant = Value::boolean(node->m_bool);
+        else if (node->type() == Node::NODE_INTEGER)
+            constant = Value::integer(node->m_value);
+        else if (node->type() == Node::NODE_STRING)
+            constant = make_object<Ob_String>(node->string());
+        else
+            constant = Ob_Fraction::make(node->m_value, node->den());
+        return [constant](Scope &) -> Value
+        {
+            return constant;
+        };
+    }
+    case Node::NODE_INFIX:
+    {
+        return compile_infix(node);
+    }
+    case Node::NODE_PREFIX:
+    {
+        return compile_prefix(node);
+    }
+    case Node::NODE_BREAKSTATEMENT:
+    {
+        return [this](Scope &) -> Value
+        {
+            return m_break;
+        };
+    }
+    case Node::NODE_CONTINUESTATEMENT:
+    {
+        return [this](Scope &) -> Value
+        {
+            return m_continue;
+        };
+    }
+    case Node::NODE_FUNCTION:
+    {
+        return compile_function(node);
+    }
+    case Node::NODE_FUNCTION_IDENTIFIER:
+    {
+        return compile_call(node);
+    }
+    case Node::NODE_RETURNSTATEMENT:
+    {
+        return compile_return(node);
+    }
+    case Node::NODE_ARRAY:
+    {
+        std::vector<Thunk> elements;
+        for (auto &ele : static_node_cast<Array>(node)->m_array)
+        {
+            elements.push_back(compile(ele));
+        }
+        return [elements](Scope &scp) -> Value
+        {
+            auto ary = make_object<Ob_Array>();
+            ary->array().reserve(elements.size());
+            for (auto &ele : elements)
+            {
+                ary->array().push_back(ele(scp));
+            }
+            return ary;
+        };
+    }
+    default:
+        throw std::invalid_argument("ClosureCompiler: node type error: " + Node::m_names[node->type()]);
+    }
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_block(const NodeRef<Node> &node)
+{
+    std::vector<Thunk> stmts;
+    for (auto &stat : node->statements())
+    {
+        stmts.push_back(compile(stat));
+    }
+    const std::vector<int> *layout = &node->locals();
+    return [this, stmts, layout](Scope &scp) -> Value
+    {
+        Scope temp_scope(&scp, layout);
+        Value result;
+        for (auto &stat : stmts)
+        {
+            result = stat(temp_scope);
+            if (is_signal(result))
+                return result;
+        }
+        return result;
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_while(const NodeRef<Node> &node)
+{
+    auto condition = compile(node->expression());
+    auto body = compile(node->cycle_statement());
+    return [this, condition, body](Scope &scp) -> Value
+    {
+        while (condition(scp).m_int)
+        {
+            Value result = body(scp);
+            if (result.m_tag != Value::VALUE_OBJECT)
+                continue;
+            if (result.m_obj == m_break.m_obj)
+                break;
+            if (result.m_obj == m_return.m_obj || result.m_obj == m_tail.m_obj)
+                return result;
+        }
+        return nullptr;
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_function(const NodeRef<Node> &node)
+{
+    // 函数体在声明时编译一次，调用时按名字找到声明节点后直接执行
+    std::vector<Thunk> body;
+    if (node->statement())
+    {
+        for (auto &stat : node->statement()->statements())
+        {
+            body.push_back(compile(stat));
+        }
+    }
+    static_cast<::Function *>(node.get())->m_compiled = std::make_shared<Function>(Function{node.get(), std::move(body)});
+
+    int name = node->func()->m_name;
+    return [node, name](Scope &scp) -> Value
+    {
+        scp.declare(name, node);
+        return nullptr;
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_call(const NodeRef<Node> &node)
+{
+    int name = node->m_name;
+    std::vector<Thunk> args;
+    for (auto &arg : node->initial_list())
+    {
+        args.push_back(compile(arg));
+    }
+    auto builtin = compile_builtin(node);
+
+    return [this, node, name, args, builtin](Scope &scp) -> Value
+    {
+        // 用户函数可能在运行时才声明，也可以覆盖内置函数，所以每次调用都按名字查找
+        auto function = find_function(name, scp);
+        if (function)
+            return call(*function, args, scp);
+        if (builtin)
+            return builtin(scp);
+        throw std::runtime_error("ClosureCompiler::call: function '" + std::string(Intern::name(name)) + "' not found");
+    };
+}
+
+Value ClosureCompiler::call(const Function &function, const std::vector<Thunk> &args, Scope &scp)
+{
+    auto &node = function.node;
+    if (node->initial_list().size() != args.size())
+    {
+        throw std::runtime_error("ClosureCompiler::call: function arguments not match");
+    }
+
+    // 实参在调用者的作用域中求值，新作用域此时对它们不可见
+    Scope temp_scp(&scp, &node->locals());
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        temp_scp.define(node->initial_list()[i]->m_name, args[i](scp));
+    }
+
+    Scope *caller = m_frame;
+    m_frame = &temp_scp;
+    const Function *current = &function;
+    Value result;
+    try
+    {
+        while (true)
+        {
+            for (auto &stat : current->body)
+            {
+                result = stat(temp_scp);
+                if (is_signal(result))
+                    break;
+            }
+            if (result.m_tag != Value::VALUE_OBJECT || result.m_obj != m_tail.m_obj)
+                break;
+
+            // 尾调用：在本层作用域中重新开始执行被调函数
+            current = m_tail_function;
+            auto &params = current->node->initial_list();
+            temp_scp.relayout(&current->node->locals());
+            size_t base = m_tail_args.size() - params.size();
+            for (size_t i = 0; i < params.size(); i++)
+            {
+                temp_scp.define(params[i]->m_name, std::move(m_tail_args[base + i]));
+            }
+            m_tail_args.resize(base);
+        }
+    }
+    catch (...)
+    {
+        m_frame = caller;
+        throw;
+    }
+    m_frame = caller;
+
+    if (result.m_tag == Value::VALUE_OBJECT && result.m_obj == m_return.m_obj)
+        return std::move(m_return_value);
+    return nullptr;
+}
+
+const ClosureCompiler::Function *ClosureCompiler::find_function(int name, Scope &scp)
+{
+    for (Scope *current_scope = &scp; current_scope != nullptr; current_scope = current_scope->father)
+    {
+        auto node = current_scope->function(name);
+        if (!node)
+            continue;
+        auto &function = static_cast<::Function *>(node->get())->m_compiled;
+        if (!function)
+            compile_function(*node);
+        return function.get();
+    }
+    return nullptr;
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_return(const NodeRef<Node> &node)
+{
+    auto value = compile(node->expression_statement());
+    auto &call = node->expression_statement()->expression();
+    if (!call || call->type() != Node::NODE_FUNCTION_IDENTIFIER)
+    {
+        return [this, value](Scope &scp) -> Value
+        {
+            m_return_value = value(scp);
+            return m_return;
+        };
+    }
+
+    int name = call->m_name;
+    std::vector<Thunk> args;
+    for (auto &arg : call->initial_list())
+    {
+        args.push_back(compile(arg));
+    }
+    return [this, value, name, args](Scope &scp) -> Value
+    {
+        // 不在函数中或调用的是内置函数时按普通 return 处理
+        auto function = m_frame ? find_function(name, scp) : nullptr;
+        if (!function)
+        {
+            m_return_value = value(scp);
+            return m_return;
+        }
+        if (function->node->initial_list().size() != args.size())
+            throw std::runtime_error("ClosureCompiler::call: function arguments not match");
+        // 实参求值时可能发生嵌套的尾调用，所以实参按栈的方式压入，由接手的调用取走
+        for (auto &arg : args)
+        {
+            m_tail_args.push_back(arg(scp));
+        }
+        scp.collapse_into(m_frame);
+        m_tail_function = function;
+        return m_tail;
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_builtin(const NodeRef<Node> &node)
+{
+    int name = node->m_name;
+    auto &args = node->initial_list();
+    auto array_of = [](const Value &value, const char *fn)
+    {
+        if (value.type() != Object::OBJECT_ARRAY)
+            throw std::invalid_argument(std::string("ClosureCompiler: function ") + fn + " expects an Array");
+        return value.m_obj;
+    };
+
+    static const int APPEND = Intern::id("append"), LEN = Intern::id("len"), PRINT = Intern::id("print"), POP = Intern::id("pop");
+    if (name == APPEND && args.size() == 2)
+    {
+        auto array = compile_container(args[0]);
+        auto element = compile(args[1]);
+        return [array, element, array_of](Scope &scp) -> Value
+        {
+            Value ele = element(scp);
+            array_of(array(scp), "append")->array().push_back(ele);
+            return nullptr;
+        };
+    }
+    if (name == LEN && args.size() == 1)
+    {
+        auto arg = compile(args[0]);
+        return [arg](Scope &scp) -> Value
+        {
+            Value obj = arg(scp);
+            if (obj.type() == Object::OBJECT_ARRAY)
+                return Value::integer(obj->array().size());
+            throw std::invalid_argument("ClosureCompiler: function len arguments not match");
+        };
+    }
+    if (name == PRINT && args.size() == 1)
+    {
+        auto arg = compile(args[0]);
+        return [arg](Scope &scp) -> Value
+        {
+            std::cout << arg(scp).str() << std::endl;
+            return nullptr;
+        };
+    }
+    if (name == POP && args.size() == 1)
+    {
+        auto array = compile_container(args[0]);
+        return [array, array_of](Scope &scp) -> Value
+        {
+            auto &elements = array_of(array(scp), "pop")->array();
+            if (elements.empty())
+                throw std::runtime_error("ClosureCompiler: pop from empty array");
+            Value top = elements.back();
+            elements.pop_back();
+            return top;
+        };
+    }
+    if (Builtins::find(name) >= 0)
+    {
+        // 其余内置函数和参数个数不对的调用交给求值器，报错也与之一致
+        return [this, node](Scope &scp) -> Value
+        {
+            return m_evaluator.eval_function(node, scp);
+        };
+    }
+    return nullptr;
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_identifier(const NodeRef<Node> &node)
+{
+    if (node->m_slot >= 0 && node->m_depth == 0)
+    {
+        int slot = node->m_slot;
+        return [this, node, slot](Scope &scp) -> Value
+        {
+            auto &var = scp.m_slots[slot];
+            if (var)
+                return var;
+            return m_evaluator.eval_identifier(node, scp);
+        };
+    }
+    if (node->m_slot >= 0)
+    {
+        int depth = node->m_depth;
+        int slot = node->m_slot;
+        return [this, node, depth, slot](Scope &scp) -> Value
+        {
+            auto &var = scp.up(depth)->m_slots[slot];
+            if (var)
+                return var;
+            return m_evaluator.eval_identifier(node, scp);
+        };
+    }
+    return [this, node](Scope &scp) -> Value
+    {
+        return m_evaluator.eval_identifier(node, scp);
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_assign(const NodeRef<Node> &ident, Thunk value)
+{
+    if (ident->m_slot >= 0 && ident->m_depth == 0)
+    {
+        int slot = ident->m_slot;
+        return [slot, value](Scope &scp) -> Value
+        {
+            Value result = value(scp);
+            scp.m_slots[slot] = result;
+            return result;
+        };
+    }
+    if (ident->m_slot >= 0)
+    {
+        int depth = ident->m_depth;
+        int slot = ident->m_slot;
+        return [depth, slot, value](Scope &scp) -> Value
+        {
+            Value result = value(scp);
+            scp.up(depth)->m_slots[slot] = result;
+            return result;
+        };
+    }
+    return [this, ident, value](Scope &scp) -> Value
+    {
+        return m_evaluator.eval_assign_expression(ident, value(scp), scp);
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_container(const NodeRef<Node> &node)
+{
+    if (node->type() == Node::NODE_IDENTIFIER)
+    {
+        return [this, node](Scope &scp) -> Value
+        {
+            return m_evaluator.eval_identifier_self(node, scp);
+        };
+    }
+    if (node->type() == Node::NODE_INFIX && node->m_operator == TokenType::LEFT_BRACKET)
+    {
+        auto index = compile(node->m_right);
+        auto array = compile_container(node->m_left);
+        return [this, index, array](Scope &scp) -> Value
+        {
+            Value idx = index(scp);
+            return m_evaluator.eval_index(array(scp), idx);
+        };
+    }
+    return [](Scope &) -> Value
+    {
+        throw std::runtime_error("ClosureCompiler::compile_container: type error");
+    };
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_infix(const NodeRef<Node> &node)
+{
+    TokenType op = node->m_operator;
+    if (op == TokenType::EQUAL)
+    {
+        auto value = compile(node->m_right);
+        if (node->m_left->type() == Node::NODE_IDENTIFIER)
+            return compile_assign(node->m_left, value);
+        if (node->m_left->m_operator == TokenType::LEFT_BRACKET)
+        {
+            auto index = compile(node->m_left->m_right);
+            auto array = compile_container(node->m_left->m_left);
+            return [index, array, value](Scope &scp) -> Value
+            {
+                long long idx = index(scp).m_int;
+                Value ay = array(scp);
+                if (ay.type() != Object::OBJECT_ARRAY)
+                    throw std::runtime_error("ClosureCompiler: can not convert '" + ay.name() + "' to Array");
+                if (idx < 0 || idx >= (long long)ay->array().size())
+                    throw std::runtime_error("ClosureCompiler: index of " + std::to_string(idx) + " out of range");
+                return ay->array()[idx] = value(scp);
+            };
+        }
+        return [](Scope &) -> Value
+        {
+            throw std::runtime_error("ClosureCompiler: not an identifier");
+        };
+    }
+
+    auto left = compile(node->m_left);
+    if (op == TokenType::LEFT_BRACKET)
+    {
+        auto index = compile(node->m_right);
+        return [this, left, index](Scope &scp) -> Value
+        {
+            Value array = left(scp);
+            Value idx = index(scp);
+            if (array.type() != Object::OBJECT_ARRAY)
+                return m_evaluator.eval_infix(TokenType::LEFT_BRACKET, array, idx, scp);
+            return m_evaluator.eval_index(array, idx);
+        };
+    }
+    // 右侧是整数常量时直接绑定常量
+    if (node->m_right->type() == Node::NODE_INTEGER)
+        return compile_binary(op, left, Value::integer(node->m_right->m_value));
+    return compile_binary(op, left, compile(node->m_right));
+}
+
+template <typename R, typename F>
+ClosureCompiler::Thunk ClosureCompiler::arithmetic(TokenType op, Thunk left, R right, F f)
+{
+    return [this, op, left, right, f](Scope &scp) -> Value
+    {
+        Value l = left(scp);
+        Value r = fetch(right, scp);
+        // 结果沿用左操作数的类型；溢出、除数为零等情况交给求值器
+        long long v;
+        if (l.is_number() && r.is_number() && f(l.m_int, r.m_int, v))
+        {
+            l.m_int = v;
+            return l;
+        }
+        return m_evaluator.eval_infix(op, l, r, scp);
+    };
+}
+
+template <typename R, typename F>
+ClosureCompiler::Thunk ClosureCompiler::comparison(TokenType op, Thunk left, R right, F f)
+{
+    return [this, op, left, right, f](Scope &scp) -> Value
+    {
+        Value l = left(scp);
+        Value r = fetch(right, scp);
+        if (l.is_number() && r.is_number())
+            return Value::boolean(f(l.m_int, r.m_int));
+        return m_evaluator.eval_infix(op, l, r, scp);
+    };
+}
+
+template <typename R>
+ClosureCompiler::Thunk ClosureCompiler::compile_binary(TokenType op, Thunk left, R right)
+{
+    switch (op)
+    {
+    case TokenType::PLUS:
+        return arithmetic(op, left, right, [](long long l, long long r, long long &out)
+                          { return !__builtin_add_overflow(l, r, &out); });
+    case TokenType::MINUS:
+        return arithmetic(op, left, right, [](long long l, long long r, long long &out)
+                          { return !__builtin_sub_overflow(l, r, &out); });
+    case TokenType::STAR:
+        return arithmetic(op, left, right, [](long long l, long long r, long long &out)
+                          { return !__builtin_mul_overflow(l, r, &out); });
+    case TokenType::SLASH_SLASH:
+        return arithmetic(op, left, right, [](long long l, long long r, long long &out)
+                          { return r != 0 && r != -1 && (out = l / r, true); });
+    case TokenType::PERCENT:
+        return arithmetic(op, left, right, [](long long l, long long r, long long &out)
+                          { return r != 0 && r != -1 && (out = l % r, true); });
+    case TokenType::EQUAL_EQUAL:
+        return comparison(op, left, right, [](long long l, long long r)
+                          { return l == r; });
+    case TokenType::BANG_EQUAL:
+        return comparison(op, left, right, [](long long l, long long r)
+                          { return l != r; });
+    case TokenType::LESS:
+        return comparison(op, left, right, [](long long l, long long r)
+                          { return l < r; });
+    case TokenType::GREATER:
+        return comparison(op, left, right, [](long long l, long long r)
+                          { return l > r; });
+    case TokenType::LESS_EQUAL:
+        return comparison(op, left, right, [](long long l, long long r)
+                          { return l <= r; });
+    case TokenType::GREATER_EQUAL:
+        return comparison(op, left, right, [](long long l, long long r)
+                          { return l >= r; });
+    default:
+        return [this, op, left, right](Scope &scp) -> Value
+        {
+            Value l = left(scp);
+            return m_evaluator.eval_infix(op, l, fetch(right, scp), scp);
+        };
+    }
+}
+
+ClosureCompiler::Thunk ClosureCompiler::compile_prefix(const NodeRef<Node> &node)
+{
+    TokenType op = node->m_operator;
+    auto &right_exp = node->m_right;
+    if (op == TokenType::PLUS_PLUS && right_exp->type() == Node::NODE_IDENTIFIER)
+    {
+        return [this, op, right_exp](Scope &scp) -> Value
+        {
+            auto var = m_evaluator.find_variable(right_exp, scp);
+            long long next;
+            if (var && var->is_number() && !__builtin_add_overflow(var->m_int, 1, &next))
+            {
+                var->m_int = next;
+                return *var;
+            }
+            return m_evaluator.eval_prefix(op, right_exp, scp);
+        };
+    }
+
+    auto right = compile(right_exp);
+    return [this, op, right](Scope &scp) -> Value
+    {
+        return prefix(op, right(scp));
+    };
+}
+
+Value ClosureCompiler::prefix(TokenType op, const Value &right)
+{
+    switch (right.type())
+    {
+    case Object::OBJECT_INTEGER:
+        return m_evaluator.eval_integer_prefix_expression(op, right);
+    case Object::OBJECT_FRACTION:
+        return m_evaluator.eval_fraction_prefix_expression(op, right);
+    case Object::OBJECT_BIGINT:
+        return m_evaluator.eval_bigint_prefix_expression(op, right);
+    case Object::OBJECT_BIGFRACTION:
+        return m_evaluator.eval_bigfraction_prefix_expression(op, right);
+    case Object::OBJECT_BOOLEAN:
+        return m_evaluator.eval_boolean_prefix_expression(op, right);
+    default:
+        throw std::runtime_error("ClosureCompiler::prefix unknown type for prefix: " + right.name());
+    }
+}
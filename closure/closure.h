@@ -0,0 +1,78 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+#include "../evaluator/evaluator.h"
+#include "../evaluator/scope.h"
+#include "../evaluator/resolver.h"
+
+// 闭包编译出的函数体，挂在函数声明节点上
+struct CompiledFunction
+{
+    Node *node; // 声明节点
+    std::vector<std::function<Value(Scope &)>> body;
+};
+
+// 闭包编译：把语法树一次性转换成预先绑定好的闭包，执行时不再对节点类型做分派
+class ClosureCompiler
+{
+public:
+    using Thunk = std::function<Value(Scope &)>;
+
+    ClosureCompiler();
+    ~ClosureCompiler() {}
+
+    Value run_program(const std::shared_ptr<Program> &program, Scope &global_scp); // 编译并执行程序的最后一条语句
+
+private:
+    using Function = CompiledFunction;
+
+    Thunk compile(const NodeRef<Node> &node);                                     // 编译语句或表达式
+    Thunk compile_block(const NodeRef<Node> &node);                               // 语句块
+    Thunk compile_while(const NodeRef<Node> &node);                               // while 语句
+    Thunk compile_function(const NodeRef<Node> &node);                            // 函数声明
+    Thunk compile_call(const NodeRef<Node> &node);                                // 函数调用
+    Thunk compile_builtin(const NodeRef<Node> &node);                             // 内置函数调用
+    Thunk compile_identifier(const NodeRef<Node> &node);                          // 读变量
+    Thunk compile_assign(const NodeRef<Node> &ident, Thunk value);                // 给变量赋值
+    Thunk compile_container(const NodeRef<Node> &node);                           // 被修改的数组（不复制）
+    Thunk compile_infix(const NodeRef<Node> &node);                               // 中缀表达式
+    Thunk compile_prefix(const NodeRef<Node> &node);                              // 前缀表达式
+    template <typename R>
+    Thunk compile_binary(TokenType op, Thunk left, R right); // 按运算符特化，R 为闭包或常量
+    template <typename R, typename F>
+    Thunk arithmetic(TokenType op, Thunk left, R right, F f); // 整数算术的快速路径
+    template <typename R, typename F>
+    Thunk comparison(TokenType op, Thunk left, R right, F f); // 整数比较的快速路径
+
+    static Value fetch(const Thunk &thunk, Scope &scp) { return thunk(scp); }
+    static Value fetch(const Value &value, Scope &) { return value; }
+
+    Value prefix(TokenType op, const Value &right);
+    Value call(const Function &function, const std::vector<Thunk> &args, Scope &scp);
+    const Function *find_function(int name, Scope &scp); // 沿作用域链查找用户函数（按需编译）
+    Thunk compile_return(const NodeRef<Node> &node); // return 语句，返回用户函数调用时作为尾调用
+    bool is_signal(const Value &value) const // break、continue、return 或尾调用
+    {
+        return value.m_tag == Value::VALUE_OBJECT &&
+               (value.m_obj == m_break.m_obj || value.m_obj == m_continue.m_obj || value.m_obj == m_return.m_obj ||
+                value.m_obj == m_tail.m_obj);
+    }
+
+private:
+    Resolver m_resolver;
+    Folder m_folder;
+    Evaluator m_evaluator; // 复用的求值器（类型组合较少见的运算和部分内置函数）
+
+    // 预先分配的控制流标记，return 的值单独存放
+    Value m_break;
+    Value m_continue;
+    Value m_return;
+    Value m_return_value;
+
+    // 尾调用：由当前函数调用复用自己的作用域执行
+    Scope *m_frame = nullptr; // 当前函数调用的作用域
+    Value m_tail;
+    const Function *m_tail_function = nullptr;
+    std::vector<Value> m_tail_args; // 尾调用的实参（栈）
+};
@@ -0,0 +1,162 @@
+#include "builtin.h"
+#include "evaluator.h"
+#include "../parser/parser.h"
+
+std::vector<Builtins::Entry> &Builtins::entries()
+{
+    static std::vector<Entry> table = {
+        {"append", 2, true, append},
+        {"len", 1, true, len},
+        {"print", 1, false, print},
+        {"eval", 1, false, eval},
+        {"scope", 0, false, scope},
+        {"pop", 1, true, pop},
+        {"int", 1, false, to_int},
+        {"input", 1, false, input},
+        {"stats", 0, false, stats},
+        {"gc", 0, false, gc},
+    };
+    return table;
+}
+
+std::vector<int> &Builtins::indices()
+{
+    static std::vector<int> map = []()
+    {
+        std::vector<int> result;
+        auto &table = entries();
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            int name = Intern::id(table[i].name);
+            if (name >= (int)result.size())
+                result.resize(name + 1, -1);
+            result[name] = (int)i;
+        }
+        return result;
+    }();
+    return map;
+}
+
+int Builtins::find(int name)
+{
+    auto &map = indices();
+    return name >= 0 && name < (int)map.size() ? map[name] : -1;
+}
+
+int Builtins::add(const char *name, int arity, bool container, Native native)
+{
+    if (arity > MAX_ARITY)
+        throw std::invalid_argument(std::string("Builtins::add: too many arguments for ") + name);
+    int id = Intern::id(name);
+    if (find(id) >= 0)
+        throw std::invalid_argument(std::string("Builtins::add: builtin ") + name + " already exists");
+    entries().push_back({name, arity, container, native});
+    int index = (int)entries().size() - 1;
+    if (id >= (int)indices().size())
+        indices().resize(id + 1, -1);
+    indices()[id] = index;
+    return index;
+}
+
+static Value &expect_array(Value &value, const char *fn)
+{
+    if (value.type() != Object::OBJECT_ARRAY)
+        throw std::invalid_argument(std::string("Builtins: function ") + fn + " expects an Array");
+    return value;
+}
+
+Value Builtins::append(Evaluator &, Value *args, Scope &)
+{
+    expect_array(args[0], "append")->array().push_back(args[1]);
+    return nullptr;
+}
+
+Value Builtins::len(Evaluator &, Value *args, Scope &)
+{
+    if (args[0].type() == Object::OBJECT_ARRAY)
+        return Value::integer(args[0]->array().size());
+    throw std::invalid_argument("Evaluator:eval_function: function len arguments not match");
+}
+
+Value Builtins::print(Evaluator &, Value *args, Scope &)
+{
+    std::cout << args[0].str() << std::endl;
+    return nullptr;
+}
+
+Value Builtins::eval(Evaluator &evaluator, Value *args, Scope &scp)
+{
+    return evaluator.eval_eval(args[0].str(), scp);
+}
+
+Value Builtins::scope(Evaluator &, Value *, Scope &scp)
+{
+    scp.print();
+    return nullptr;
+}
+
+Value Builtins::stats(Evaluator &, Value *, Scope &)
+{
+    std::cout << Object::stats() << std::endl;
+    return nullptr;
+}
+
+Value Builtins::gc(Evaluator &, Value *, Scope &)
+{
+    return Value::integer(Collector::collect());
+}
+
+Value Builtins::pop(Evaluator &, Value *args, Scope &)
+{
+    auto &array = expect_array(args[0], "pop")->array();
+    if (array.empty())
+        throw std::runtime_error("Evaluator:eval_pop: pop from empty array");
+    auto top = array.back();
+    array.pop_back();
+    return top;
+}
+
+Value Builtins::to_int(Evaluator &, Value *args, Scope &)
+{
+    auto &obj = args[0];
+    switch (obj.type())
+    {
+    case Object::OBJECT_INTEGER:
+        return obj;
+    case Object::OBJECT_FRACTION:
+    {
+        Rational fraction = Ob_Fraction::of(obj);
+        return Value::integer(fraction.num / fraction.den);
+    }
+    case Object::OBJECT_BOOLEAN:
+        return Value::integer(obj.m_int);
+    case Object::OBJECT_STRING:
+        return Value::integer(std::stoll(obj->string()));
+    default:
+        throw std::runtime_error("Evaluator:eval_function: can not convert " + obj.name() + " to Integer");
+    }
+}
+
+// 读一行（跳过行首空格），最多 size - 1 个字符
+static void read(char *inpt, int size)
+{
+    int len = 0;
+    int c = getchar();
+    while (c == ' ')
+        c = getchar();
+    while (c != '\n' && c != EOF && len < size - 1)
+    {
+        inpt[len++] = (char)c;
+        c = getchar();
+    }
+    inpt[len] = '\0';
+}
+
+Value Builtins::input(Evaluator &, Value *args, Scope &)
+{
+    if (args[0].type() == Object::OBJECT_STRING)
+        std::cout << args[0]->string();
+    char inpt[1024];
+    read(inpt, sizeof(inpt));
+    return make_object<Ob_String>(inpt);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include "scope.h"
+#include "../object/object.h"
+
+class Evaluator;
+
+// 内置函数表：按名字在符号表中的编号登记，调用点缓存的是表中的下标
+class Builtins
+{
+public:
+    static constexpr int MAX_ARITY = 4;
+
+    // 参数已求值；登记为 container 的函数，args[0] 是变量中的数组本身而不是副本
+    using Native = Value (*)(Evaluator &evaluator, Value *args, Scope &scp);
+
+    struct Entry
+    {
+        const char *name;
+        int arity;
+        bool container;
+        Native native;
+    };
+
+    static int find(int name); // 名字编号对应的下标，没有则返回 -1
+    static const Entry &at(int index) { return entries()[index]; }
+    static int add(const char *name, int arity, bool container, Native native); // 登记新的内置函数
+
+private:
+    static std::vector<Entry> &entries();
+    static std::vector<int> &indices(); // 以名字编号为下标，-1 表示不是内置函数
+
+    static Value append(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value len(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value print(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value eval(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value scope(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value pop(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value to_int(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value input(Evaluator &evaluator, Value *args, Scope &scp);
+    static Value stats(Evaluator &evaluator, Value *args, Scope &scp); // 运行时对象的统计
+    static Value gc(Evaluator &evaluator, Value *args, Scope &scp);    // 立即回收数组的环，返回释放的数组数
+};
@@ -1,12 +1,12 @@
 #include "evaluator.h"
 
-std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope &scp)
+Value Evaluator::eval(const NodeRef<Node> &node, Scope &scp)
 {
     switch (node->type())
     {
     case Node::NODE_STATEMENTBLOCK:
     {
-        return eval_statement_block(node->m_statements, scp);
+        return eval_statement_block(node, scp);
     }
     case Node::NODE_IFSTATEMENT:
     {
@@ -14,11 +14,11 @@ std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope
     }
     case Node::NODE_WHILESTATEMENT:
     {
-        return eval_while_statement(node->m_expression, node->m_cycle_statement, scp);
+        return eval_while_statement(node->expression(), node->cycle_statement(), scp);
     }
     case Node::NODE_EXPRESSION_STATEMENT:
     {
-        return eval(node->m_expression, scp);
+        return eval(node->expression(), scp);
     }
     case Node::NODE_IDENTIFIER:
     {
@@ -26,15 +26,19 @@ std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope
     }
     case Node::NODE_BOOLEAN:
     {
-        return std::make_shared<Ob_Boolean>(node->m_bool);
+        return Value::boolean(node->m_bool);
     }
     case Node::NODE_INTEGER:
     {
-        return std::make_shared<Ob_Integer>(node->m_value);
+        return Value::integer(node->m_value);
     }
     case Node::NODE_STRING:
     {
-        return std::make_shared<Ob_String>(node->m_string);
+        return make_object<Ob_String>(node->string());
+    }
+    case Node::NODE_FRACTION:
+    {
+        return Ob_Fraction::make(node->m_value, node->den());
     }
     case Node::NODE_INFIX:
     {
@@ -42,14 +46,17 @@ std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope
         {
             if (node->m_left->type() == Node::NODE_IDENTIFIER)
             {
-                auto name = node->m_left->m_name;
-                return eval_assign_expression(name, eval(node->m_right, scp), scp);
+                return eval_assign_expression(node->m_left, eval(node->m_right, scp), scp);
             }
             if (node->m_left->m_operator == TokenType::LEFT_BRACKET)
             {
-                int idex = eval(node->m_left->m_right, scp)->m_int;
+                long long idex = eval(node->m_left->m_right, scp).m_int;
                 auto ay = eval_array(node->m_left->m_left, scp);
-                return ay->m_array[idex] = eval(node->m_right, scp);
+                if (ay.type() != Object::OBJECT_ARRAY)
+                    throw std::runtime_error("Evaluator::eval: can not convert '" + ay.name() + "' to Array");
+                if (idex < 0 || idex >= (long long)ay->array().size())
+                    throw std::runtime_error("Evaluator::eval: index of " + std::to_string(idex) + " out of range");
+                return ay->array()[idex] = eval(node->m_right, scp);
             }
             throw std::runtime_error("Evaluator::eval_left: not an identifier: ");
         }
@@ -66,11 +73,11 @@ std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope
     }
     case Node::NODE_BREAKSTATEMENT:
     {
-        return std::make_shared<Ob_Break>();
+        return m_break;
     }
     case Node::NODE_CONTINUESTATEMENT:
     {
-        return std::make_shared<Ob_Continue>();
+        return m_continue;
     }
     case Node::NODE_FUNCTION:
     {
@@ -82,14 +89,14 @@ std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope
     }
     case Node::NODE_RETURNSTATEMENT:
     {
-        return std::make_shared<Ob_Return>(eval(node->m_expression_statement, scp));
+        return eval_return_statement(node, scp);
     }
     case Node::NODE_ARRAY:
     {
-        auto ary = std::make_shared<Ob_Array>();
-        for (auto ele : std::dynamic_pointer_cast<Array>(node)->m_array)
+        auto ary = make_object<Ob_Array>();
+        for (auto ele : dynamic_node_cast<Array>(node)->m_array)
         {
-            ary->m_array.push_back(eval(ele, scp));
+            ary->array().push_back(eval(ele, scp));
         }
         return ary;
     }
@@ -99,14 +106,14 @@ std::shared_ptr<Object> Evaluator::eval(const std::shared_ptr<Node> &node, Scope
     }
 }
 
-std::shared_ptr<Object> Evaluator::eval_program(const std::shared_ptr<Program> &node, Scope &global_scp)
+Value Evaluator::eval_program(const std::shared_ptr<Program> &node, Scope &global_scp)
 {
-    function_map = node->function_map;
-    identifier_map = node->identifier_map;
-
-    if (node->m_statements.empty())
+    if (node->statements().empty())
         throw std::runtime_error("Evaluator::eval: empty program");
-    std::shared_ptr<Object> result = eval(*(--node->m_statements.end()), global_scp);
+    m_folder.fold_program(node, *this);
+    m_resolver.resolve_program(node, global_scp);
+    m_tail_args.clear(); // 上次出错时可能留下未取走的实参
+    Value result = eval(*(--node->statements().end()), global_scp);
     // for (auto &stat : stmts)
     // {
     //     result = eval(stat);
@@ -118,59 +125,23 @@ std::shared_ptr<Object> Evaluator::eval_program(const std::shared_ptr<Program> &
     return result;
 }
 
-std::shared_ptr<Object> Evaluator::eval_array(const std::shared_ptr<Node> node, Scope &scp)
+Value Evaluator::eval_array(const NodeRef<Node> node, Scope &scp)
 {
     if (node->type() == Node::NODE_IDENTIFIER)
     {
-        auto it = scp.m_var.find(node->m_name);
-        if (it != scp.m_var.end())
-        {
-            return it->second;
-        }
-
-        auto current_scope = &scp;
-        while (current_scope->father != nullptr)
-        {
-            current_scope = current_scope->father;
-            auto it = current_scope->m_var.find(node->m_name);
-            if (it != current_scope->m_var.end())
-            {
-                return it->second;
-            }
-        }
-        throw std::runtime_error("Evaluator::eval_assign_arraaay: identifier not found");
+        return eval_identifier_self(node, scp);
     }
     if (node->type() == Node::NODE_INFIX && node->m_operator == TokenType::LEFT_BRACKET)
     {
-        int idex = eval(node->m_right, scp)->m_int;
-        if (node->m_left->type() == Node::NODE_IDENTIFIER)
-        {
-            auto it = scp.m_var.find(node->m_left->m_name);
-            if (it != scp.m_var.end())
-            {
-                return it->second->m_array[idex];
-            }
-
-            auto current_scope = &scp;
-            while (current_scope->father != nullptr)
-            {
-                current_scope = current_scope->father;
-                auto it = current_scope->m_var.find(node->m_name);
-                if (it != current_scope->m_var.end())
-                {
-                    return it->second->m_array[idex];
-                }
-            }
-            // node->m_left->m_name
-            throw std::runtime_error("Evaluator::eval_assign_array: identifier  not found");
-        }
-        else
-        {
-            auto array = eval_array(node->m_left, scp);
-            if (array->type() == Object::OBJECT_ERROR)
-                return array;
-            return array->m_array[idex];
-        }
+        long long idex = eval(node->m_right, scp).m_int;
+        auto array = eval_array(node->m_left, scp);
+        if (array.type() == Object::OBJECT_ERROR)
+            return array;
+        if (array.type() != Object::OBJECT_ARRAY)
+            throw std::runtime_error("Evaluator::eval_array: can not convert '" + array.name() + "' to Array");
+        if (idex < 0 || idex >= (long long)array->array().size())
+            throw std::runtime_error("Evaluator::eval_array: index of " + std::to_string(idex) + " out of range");
+        return array->array()[idex];
     }
     throw std::runtime_error("Evaluator::eval_assign_array: type error");
 }
\ No newline at end of file
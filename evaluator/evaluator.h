@@ -3,6 +3,9 @@
 #include <memory>
 #include <unordered_map>
 #include "scope.h"
+#include "resolver.h"
+#include "folder.h"
+#include "builtin.h"
 #include "../ast/node.h"
 #include "../ast/statement.h"
 #include "../ast/infix.h"
@@ -12,58 +15,75 @@
 
 class Evaluator
 {
+    friend class VM;
+    friend class ClosureCompiler;
+    friend class Folder;
+    friend class Builtins;
+
 private:
     Scope scope;
-    std::unordered_map<int, std::string> *identifier_map; // 标识符反映射
-    std::unordered_map<int, std::string> *function_map;   // 函数反映射
+    Resolver m_resolver;
+    Folder m_folder;
+
+    // 尾调用：return f(...) 不递归求值，而是返回标记，由当前函数调用复用自己的作用域执行 f
+    Scope *m_frame = nullptr;              // 当前函数调用的作用域
+    Value m_tail_call;                     // 尾调用标记
+    std::shared_ptr<Node> m_tail_function; // 尾调用的函数
+    std::vector<Value> m_tail_args;        // 尾调用的实参（栈）
+
+    // break、continue、return 的结果只是不可变的标记，共用同一个对象，不再每次创建
+    Value m_break;
+    Value m_continue;
+    Value m_return;       // return 标记
+    Value m_return_value; // return 的值，由接收 return 标记的函数调用取走
 
 public:
-    Evaluator() {}
+    Evaluator()
+        : m_tail_call(make_object<Ob_Return>(Value())), m_break(make_object<Ob_Break>()),
+          m_continue(make_object<Ob_Continue>()), m_return(make_object<Ob_Return>(Value())) {}
     ~Evaluator() {}
 
-    std::shared_ptr<Object> eval(const std::shared_ptr<Node> &node, Scope &scp);                   // 求值
-    std::shared_ptr<Object> eval_program(const std::shared_ptr<Program> &node, Scope &global_scp); // 对根节点求值
+    Value eval(const NodeRef<Node> &node, Scope &scp);                           // 求值
+    Value eval_program(const std::shared_ptr<Program> &node, Scope &global_scp); // 对根节点求值
 
 private:
-    std::shared_ptr<Object> eval_statement_block(const std::vector<std::shared_ptr<Node>> &stmts, Scope &scp); // 对语句块求值
-    std::shared_ptr<Object> eval_function_block(const std::shared_ptr<Node> function,
-                                                std::shared_ptr<Node> node, Scope &scp); // 对函数语句块求值
+    Value eval_statement_block(const NodeRef<Node> &node, Scope &scp); // 对语句块求值
+    Value eval_function_block(std::shared_ptr<Node> function,
+                              NodeRef<Node> node, Scope &scp); // 对函数语句块求值
 
-    // std::shared_ptr<Object> eval_function_block(const std::vector<std::shared_ptr<Statement>> &stmts, Scope &temp_scp); // 对函数语句块求值
-    std::shared_ptr<Object> eval_array(const std::shared_ptr<Node>, Scope &scp);                                                            // 对数组求值
-    std::shared_ptr<Object> eval_if_statement(const std::shared_ptr<Node> &node, Scope &scp);                                               // 对if语句求值
-    std::shared_ptr<Object> eval_while_statement(const std::shared_ptr<Node> &exp, const std::shared_ptr<Node> true_statement, Scope &scp); // 对语句块求值
+    // Value eval_function_block(const std::vector<NodeRef<Statement>> &stmts, Scope &temp_scp); // 对函数语句块求值
+    Value eval_array(const NodeRef<Node>, Scope &scp);                                                    // 对数组求值
+    Value eval_if_statement(const NodeRef<Node> &node, Scope &scp);                                       // 对if语句求值
+    Value eval_while_statement(const NodeRef<Node> &exp, const NodeRef<Node> true_statement, Scope &scp); // 对语句块求值
 
     // return clone
-    std::shared_ptr<Object> eval_identifier(const std::shared_ptr<Node> &node, Scope &scp); // 对标识符求值
+    Value eval_identifier(const NodeRef<Node> &node, Scope &scp); // 对标识符求值
     // return self
-    std::shared_ptr<Object> eval_identifier_self(const std::shared_ptr<Node> &node, Scope &scp); // 对标识符求值
+    Value eval_identifier_self(const NodeRef<Node> &node, Scope &scp); // 对标识符求值
+    Value *find_variable(const NodeRef<Node> &node, Scope &scp);       // 查找变量所在位置
 
-    std::shared_ptr<Object> eval_function_declaration(const std::shared_ptr<Node> &node, Scope &scp); // 对函数声明求值
-    std::shared_ptr<Object> eval_function(const std::shared_ptr<Node> &node, Scope &scp);             // 对函数调用求值
-    std::shared_ptr<Object> eval_return_statement(const std::shared_ptr<Node> &node, Scope &scp);     // 对返回语句求值
+    Value eval_function_declaration(const NodeRef<Node> &node, Scope &scp); // 对函数声明求值
+    Value eval_function(const NodeRef<Node> &node, Scope &scp);             // 对函数调用求值
+    void resolve_call(FunctionIdentifier &node, Scope &scp);                // 解析调用点并写入缓存
+    Value eval_builtin(int builtin, const NodeRef<Node> &node, Scope &scp); // 按内置函数表的下标调用
+    Value eval_return_statement(const NodeRef<Node> &node, Scope &scp);     // 对返回语句求值
 
-    std::shared_ptr<Object> eval_index(std::shared_ptr<Object> &name,
-                                       const std::shared_ptr<Object> &index, Scope &scp); // 对数组索引求值
-    std::shared_ptr<Object> eval_assign_expression(const int &name,
-                                                   const std::shared_ptr<Object> &value, Scope &scp); // 赋值语句
-    std::shared_ptr<Object> eval_infix(const TokenType op, std::shared_ptr<Object> &left,
-                                       const std::shared_ptr<Object> &right, Scope &Scp); // 对中缀表达式求值
-    std::shared_ptr<Object> eval_integer_infix_expression(const TokenType &op, const std::shared_ptr<Object> &left,
-                                                          const std::shared_ptr<Object> &right); // 整数中缀表达式
-    std::shared_ptr<Object> eval_fraction_infix_expression(const TokenType &op, const std::shared_ptr<Object> &left,
-                                                           const std::shared_ptr<Object> &right);                       // 分数中缀表达式
-    std::shared_ptr<Object> eval_prefix(const TokenType &op, const std::shared_ptr<Expression> &right_exp, Scope &scp); // 对前缀表达式求值
-    std::shared_ptr<Object> eval_integer_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right);  // 对整数前缀表达式求值
-    std::shared_ptr<Object> eval_fraction_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right); // 对分数前缀表达式求值
-    std::shared_ptr<Object> eval_boolean_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right);  // 对布尔前缀表达式求值
-    std::shared_ptr<Object> eval_trignometry_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right);
+    Value eval_index(const Value &name, const Value &index);                                            // 对数组索引求值
+    Value eval_assign_expression(const NodeRef<Node> &ident, const Value &value, Scope &scp);           // 赋值语句
+    Value eval_infix(const TokenType op, const Value &left, const Value &right, Scope &Scp);             // 对中缀表达式求值
+    Value eval_integer_infix_expression(const TokenType &op, const Value &left, const Value &right);    // 整数中缀表达式
+    Value eval_fraction_infix_expression(const TokenType &op, const Rational &left, const Rational &right); // 分数中缀表达式
+    Value eval_bigfraction_infix_expression(const TokenType &op, const BigRational &left, const BigRational &right); // 大分数中缀表达式
+    Value eval_bigint_infix_expression(const TokenType &op, const BigInt &left, const BigInt &right);   // 大整数中缀表达式
+    Value eval_prefix(const TokenType &op, const NodeRef<Expression> &right_exp, Scope &scp); // 对前缀表达式求值
+    Value eval_integer_prefix_expression(const TokenType &op, const Value &right);                      // 对整数前缀表达式求值
+    Value eval_fraction_prefix_expression(const TokenType &op, const Value &right);                     // 对分数前缀表达式求值
+    Value eval_bigint_prefix_expression(const TokenType &op, const Value &right);                       // 对大整数前缀表达式求值
+    Value eval_bigfraction_prefix_expression(const TokenType &op, const Value &right);                  // 对大分数前缀表达式求值
+    Value eval_boolean_prefix_expression(const TokenType &op, const Value &right);                      // 对布尔前缀表达式求值
+    Value eval_trignometry_prefix_expression(const TokenType &op, const Value &right);
 
     /*内置函数*/
-    std::shared_ptr<Object> eval_eval(const std::string &line, Scope &scp);             // 对eval函数求值
-    std::shared_ptr<Object> eval_append(const std::shared_ptr<Node> &node, Scope &scp); // 对append函数求值
-    std::shared_ptr<Object> eval_pop(const std::shared_ptr<Node> &node, Scope &scp);    // 对pop函数求值
-    std::shared_ptr<Object> eval_int(const std::shared_ptr<Node> &node, Scope &scp);    // 对int类型转化函数求值
-    std::shared_ptr<Object> eval_input(const std::shared_ptr<Node> &node, Scope &scp);
-    // std::shared_ptr<Object> eval_ast();
+    Value eval_eval(const std::string &line, Scope &scp); // 对eval函数求值
+    // Value eval_ast();
 };
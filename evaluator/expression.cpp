@@ -2,8 +2,9 @@
 #include "../lexer/lexer.h"
 #include "../parser/parser.h"
 #include <cmath>
+#include <climits>
 
-std::shared_ptr<Object> Evaluator::eval_eval(const std::string &line, Scope &scp)
+Value Evaluator::eval_eval(const std::string &line, Scope &scp)
 {
     Lexer lexer;
     Parser parser;
@@ -21,107 +22,101 @@ std::shared_ptr<Object> Evaluator::eval_eval(const std::string &line, Scope &scp
     return nullptr;
 }
 
-std::shared_ptr<Object> Evaluator::eval_function(const std::shared_ptr<Node> &node, Scope &scp)
+Value Evaluator::eval_function(const NodeRef<Node> &node, Scope &scp)
 {
-    auto name = node->m_name;
-    auto it = scp.m_func.find(name);
-    if (it == scp.m_func.end())
+    auto &call = static_cast<FunctionIdentifier &>(*node);
+    if (call.m_call_epoch != Scope::function_epoch(call.m_name))
+        resolve_call(call, scp);
+    if (call.m_callee)
+        return eval_function_block(*call.m_callee, node, scp);
+    return eval_builtin(call.m_builtin, node, scp);
+}
+
+void Evaluator::resolve_call(FunctionIdentifier &node, Scope &scp)
+{
+    // 存活的作用域总在当前作用域链上，所以在下一次声明同名函数（或声明它的作用域销毁）之前，
+    // 同一调用点总会解析到同一个函数
+    auto name = node.m_name;
+    for (Scope *current_scope = &scp; current_scope != nullptr; current_scope = current_scope->father)
     {
-        auto current_scope = &scp;
-        while (current_scope->father != nullptr)
+        auto function = current_scope->function(name);
+        if (function)
         {
-            current_scope = current_scope->father;
-            it = current_scope->m_func.find(name);
-            if (it != current_scope->m_func.end())
-            {
-                return eval_function_block(it->second, node, scp);
-            }
+            node.m_callee = function;
+            node.m_builtin = -1;
+            node.m_call_epoch = Scope::function_epoch(name);
+            return;
         }
+    }
 
-        if (name == Parser::prehash("append"))
-        {
-            return eval_append(node, scp);
-        }
-        if (name == Parser::prehash("len"))
-        {
-            auto obj = eval(node->m_initial_list[0], scp);
-            if (obj->type() == Object::OBJECT_ARRAY)
-            {
-                return std::make_shared<Ob_Integer>(obj->m_array.size());
-            }
-            throw std::invalid_argument("Evaluator:eval_function: function len arguments not match");
-        }
-        if (name == Parser::prehash("print"))
-        {
-            std::cout << eval(node->m_initial_list[0], scp)->str() << std::endl;
-            return nullptr;
-        }
-        if (name == Parser::prehash("eval"))
-        {
-            return eval_eval(eval(node->m_initial_list[0], scp)->str(), scp);
-        }
-        if (name == Parser::prehash("scope"))
-        {
-            scp.print(identifier_map, function_map);
-            return nullptr;
-        }
-        if (name == Parser::prehash("pop"))
-        {
-            return eval_pop(node, scp);
-        }
-        if (name == Parser::prehash("int"))
-        {
-            return eval_int(node, scp);
-        }
-        if (name == Parser::prehash("input"))
-        {
-            return eval_input(node, scp);
-        }
-        if (name == Parser::prehash("__ast__"))
-        {
-            // return eval_ast();
-        }
-        throw std::runtime_error("Evaluator::eval_function: function '" + function_map->find(name)->second + "' not found");
+    int builtin = Builtins::find(name);
+    if (builtin < 0)
+        throw std::runtime_error("Evaluator::eval_function: function '" + std::string(Intern::name(name)) + "' not found");
+    node.m_callee = nullptr;
+    node.m_builtin = builtin;
+    node.m_call_epoch = Scope::function_epoch(name);
+}
+
+Value Evaluator::eval_builtin(int builtin, const NodeRef<Node> &node, Scope &scp)
+{
+    auto &entry = Builtins::at(builtin);
+    auto &list = node->initial_list();
+    if ((int)list.size() != entry.arity)
+        throw std::invalid_argument(std::string("Evaluator:eval_function: function ") + entry.name + " arguments not match");
+
+    Value args[Builtins::MAX_ARITY];
+    for (int i = 0; i < entry.arity; i++)
+    {
+        // 修改数组的内置函数拿到变量中的数组本身
+        bool self = i == 0 && entry.container &&
+                    (list[0]->type() == Node::NODE_IDENTIFIER ||
+                     (list[0]->type() == Node::NODE_INFIX && list[0]->m_operator == TokenType::LEFT_BRACKET));
+        args[i] = self ? eval_array(list[0], scp) : eval(list[i], scp);
     }
-    return eval_function_block(it->second, node, scp);
+    return entry.native(*this, args, scp);
 }
 
-std::shared_ptr<Object> Evaluator::eval_assign_expression(const int &name, const std::shared_ptr<Object> &value, Scope &scp)
+Value Evaluator::eval_assign_expression(const NodeRef<Node> &ident, const Value &value, Scope &scp)
 {
-    auto it = scp.m_var.find(name);
-    if (it != scp.m_var.end())
+    if (ident->m_slot >= 0)
     {
-        it->second = value;
+        scp.up(ident->m_depth)->m_slots[ident->m_slot] = value;
         return value;
     }
 
-    Scope *temp_scp = &scp;
-    while (temp_scp->father)
+    auto var = scp.lookup(ident->m_name);
+    if (var)
     {
-        temp_scp = temp_scp->father;
-        auto it = temp_scp->m_var.find(name);
-        if (it != temp_scp->m_var.end())
-        {
-            it->second = value;
-            return value;
-        }
+        *var = value;
+        return value;
     }
 
-    scp.m_var.insert(std::make_pair(name, value));
+    scp.define(ident->m_name, value);
     return value;
 }
 
-std::shared_ptr<Object> Evaluator::eval_prefix(const TokenType &op, const std::shared_ptr<Expression> &right_exp, Scope &scp)
+Value Evaluator::eval_prefix(const TokenType &op, const NodeRef<Expression> &right_exp, Scope &scp)
 {
     if (op == TokenType::PLUS_PLUS && right_exp->type() == Node::NODE_IDENTIFIER)
     {
-        auto right = eval_identifier_self(right_exp, scp);
-        right->m_int += 1;
-        return right;
+        auto var = find_variable(right_exp, scp);
+        if (!var)
+            throw std::runtime_error("Evaluator::eval_prefix: identifier '" + std::string(Intern::name(right_exp->m_name)) + "' not found");
+        long long next;
+        if (var->is_number() && !__builtin_add_overflow(var->m_int, 1, &next))
+        {
+            var->m_int = next;
+            return *var;
+        }
+        if (var->is_number() || var->type() == Object::OBJECT_BIGINT)
+        {
+            *var = Ob_BigInt::make(BigInt::add(Ob_BigInt::of(*var), 1));
+            return *var;
+        }
     }
 
     auto right = eval(right_exp, scp);
-    switch (right->type())
+    switch (right.type())
     {
     case Object::OBJECT_INTEGER:
     {
@@ -131,6 +126,14 @@ std::shared_ptr<Object> Evaluator::eval_prefix(const TokenType &op, const std::s
     {
         return eval_fraction_prefix_expression(op, right);
     }
+    case Object::OBJECT_BIGINT:
+    {
+        return eval_bigint_prefix_expression(op, right);
+    }
+    case Object::OBJECT_BIGFRACTION:
+    {
+        return eval_bigfraction_prefix_expression(op, right);
+    }
     case Object::OBJECT_BOOLEAN:
     {
         return eval_boolean_prefix_expression(op, right);
@@ -142,318 +145,479 @@ std::shared_ptr<Object> Evaluator::eval_prefix(const TokenType &op, const std::s
     default:
         break;
     }
-    throw std::runtime_error("Evaluator::eval_prefix unknown type for prefix: " + right->name());
+    throw std::runtime_error("Evaluator::eval_prefix unknown type for prefix: " + right.name());
+}
+
+Value Evaluator::eval_integer_prefix_expression(const TokenType &op, const Value &right)
+{
+    if (op == TokenType::PLUS)
+    {
+        return right;
+    }
+    else if (op == TokenType::MINUS)
+    {
+        long long result;
+        if (__builtin_sub_overflow(0, right.m_int, &result))
+            return Ob_BigInt::make(BigInt::negate(right.m_int));
+        return Value::integer(result);
+    }
+    else if (op == TokenType::PLUS_PLUS)
+    {
+        long long result;
+        if (__builtin_add_overflow(right.m_int, 1, &result))
+            return Ob_BigInt::make(BigInt::add(right.m_int, 1));
+        return Value::integer(result);
+    }
+    throw std::runtime_error("Evaluator::eval_integer_prefix_expression unknown operation: " + TokenTypeToString[op] + " " + right.name());
 }
 
-std::shared_ptr<Object> Evaluator::eval_integer_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right)
+Value Evaluator::eval_bigint_prefix_expression(const TokenType &op, const Value &right)
 {
-    auto r = std::dynamic_pointer_cast<Ob_Integer>(right);
     if (op == TokenType::PLUS)
     {
-        return std::make_shared<Ob_Integer>(r->m_int);
+        return right;
     }
     else if (op == TokenType::MINUS)
     {
-        return std::make_shared<Ob_Integer>(-r->m_int);
+        return Ob_BigInt::make(BigInt::negate(right->bigint()));
     }
     else if (op == TokenType::PLUS_PLUS)
     {
-        return std::make_shared<Ob_Integer>(++(r->m_int));
+        return Ob_BigInt::make(BigInt::add(right->bigint(), 1));
+    }
+    throw std::runtime_error("Evaluator::eval_bigint_prefix_expression: unknown operation: " + TokenTypeToString[op] + " " + right.name());
+}
+
+Value Evaluator::eval_fraction_prefix_expression(const TokenType &op, const Value &right)
+{
+    if (op == TokenType::PLUS)
+    {
+        return right;
     }
-    throw std::runtime_error("Evaluator::eval_integer_prefix_expression unknown operation: " + TokenTypeToString[op] + " " + right->name());
+    else if (op == TokenType::MINUS)
+    {
+        Rational value = Ob_Fraction::of(right);
+        if (value.num == LLONG_MIN)
+            return Ob_BigFraction::make(BigRational(BigInt::negate(value.num), value.den));
+        return Ob_Fraction::make(Rational{-value.num, value.den});
+    }
+    throw std::runtime_error("Evaluator::eval_fraction_prefix_expression: unknown operation: " + TokenTypeToString[op] + " " + right.name());
 }
 
-std::shared_ptr<Object> Evaluator::eval_fraction_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right)
+Value Evaluator::eval_bigfraction_prefix_expression(const TokenType &op, const Value &right)
 {
     if (op == TokenType::PLUS)
     {
-        return std::make_shared<Ob_Fraction>(right->num, right->den);
+        return right;
     }
     else if (op == TokenType::MINUS)
     {
-        return std::make_shared<Ob_Fraction>(-right->num, right->den);
+        auto value = Ob_BigFraction::of(right);
+        return Ob_BigFraction::make(BigRational(BigInt::negate(value.num), value.den));
     }
-    throw std::runtime_error("Evaluator::eval_fraction_prefix_expression: unknown operation: " + TokenTypeToString[op] + " " + right->name());
+    throw std::runtime_error("Evaluator::eval_bigfraction_prefix_expression: unknown operation: " + TokenTypeToString[op] + " " + right.name());
 }
 
-std::shared_ptr<Object> Evaluator::eval_boolean_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right)
+Value Evaluator::eval_boolean_prefix_expression(const TokenType &op, const Value &right)
 {
     if (op == TokenType::BANG || op == TokenType::MINUS)
     {
-        return std::make_shared<Ob_Boolean>(!right->m_int);
+        return Value::boolean(!right.m_int);
     }
-    throw std::runtime_error("Evaluator::eval_boolean_prefix_expression: unknown operation: " + TokenTypeToString[op] + " " + right->name());
+    throw std::runtime_error("Evaluator::eval_boolean_prefix_expression: unknown operation: " + TokenTypeToString[op] + " " + right.name());
 }
 /*
-std::shared_ptr<Object> Evaluator::eval_trignometry_prefix_expression(const TokenType &op, const std::shared_ptr<Object> &right)
+Value Evaluator::eval_trignometry_prefix_expression(const TokenType &op, const Value &right)
 {
     // auto r = std::dynamic_pointer_cast<Ob_Trignometry>(right);
     // if (op == TokenType::SIN)
     // {
-    //     return std::make_shared<Ob_Trignometry>(std::sin(r->m_int));
+    //     return make_object<Ob_Trignometry>(std::sin(r->m_int));
     // }
     // else if (op == TokenType::COS)
     // {
-    //     return std::make_shared<Ob_Trignometry>(std::cos(r->m_int));
+    //     return make_object<Ob_Trignometry>(std::cos(r->m_int));
     // }
     // else if (op == TokenType::TAN)
     // {
-    //     return std::make_shared<Ob_Trignometry>(std::tan(r->m_int));
+    //     return make_object<Ob_Trignometry>(std::tan(r->m_int));
     // }
     // else if (op == TokenType::MINUS)
     // {
-    //     return std::make_shared<Ob_Trignometry>(-r->m_int);
+    //     return make_object<Ob_Trignometry>(-r->m_int);
     // }
     // else
     // {
-    //     return new_error("Evaluator: unknown operator: %s %s", TokenTypeToString[op], right->name());
+    //     return new_error("Evaluator: unknown operator: %s %s", TokenTypeToString[op], right.name());
     // }
     return nullptr;
 }
 */
-std::shared_ptr<Object> Evaluator::eval_infix(const TokenType op, std::shared_ptr<Object> &left,
-                                              const std::shared_ptr<Object> &right, Scope &scp) // 中缀表达式求值
+Value Evaluator::eval_infix(const TokenType op, const Value &left, const Value &right, Scope &) // 中缀表达式求值
 {
-    // std::cout << "eval_infix: " << left->str() << "(" << left->name() << ") " << TokenTypeToString[op]
-    //           << " " << right->str() << "(" << right->name() << ")" << std::endl;
-
-    // assign
-    // if (op == TokenType::EQUAL)
-    // {
-    //     // if (left->type() != Object::OBJECT_IDENTIFIER)
-    //     // return eval_assgin_array_statement(left, right, scp);
-    //     if (left->type() == Object::OBJECT_IDENTIFIER)
-    //         return eval_assign_expression(left, right, scp);
-    // }
+    // std::cout << "eval_infix: " << left.str() << "(" << left.name() << ") " << TokenTypeToString[op]
+    //           << " " << right.str() << "(" << right.name() << ")" << std::endl;
 
     if (op == TokenType::LEFT_BRACKET)
     {
-        if (left->type() != Object::OBJECT_ARRAY)
-            throw std::runtime_error("Evaluator: can not convert '" + left->name() + "' to Array");
-        return eval_index(left, right, scp);
+        if (left.type() != Object::OBJECT_ARRAY)
+            throw std::runtime_error("Evaluator: can not convert '" + left.name() + "' to Array");
+        return eval_index(left, right);
     }
     // int(bool) op int(bool)
-    if (((left->type() == Object::OBJECT_INTEGER) || (left->type() == Object::OBJECT_BOOLEAN)) &&
-        ((right->type() == Object::OBJECT_INTEGER) || (right->type() == Object::OBJECT_BOOLEAN)))
+    if (left.is_number() && right.is_number())
         return eval_integer_infix_expression(op, left, right);
 
-    // fraction op fraction
-    if (left->type() == Object::OBJECT_FRACTION && right->type() == Object::OBJECT_FRACTION)
-        return eval_fraction_infix_expression(op, left, right);
+    if (!left || !right)
+        throw std::runtime_error("Evaluator::eval_infix: operand of " + TokenTypeToString[op] + " has no value");
 
-    // fraction op int
-    if (left->type() == Object::OBJECT_FRACTION && right->type() == Object::OBJECT_INTEGER)
-        return eval_fraction_infix_expression(op, left, std::make_shared<Ob_Fraction>(right->m_int, 1));
+    auto lt = left.type(), rt = right.type();
 
-    // int op fraction
-    if (left->type() == Object::OBJECT_INTEGER && right->type() == Object::OBJECT_FRACTION)
-        return eval_fraction_infix_expression(op, std::make_shared<Ob_Fraction>(left->m_int, 1), right);
+    // fraction op fraction，fraction op int(bool)，int(bool) op fraction
+    if ((lt == Object::OBJECT_FRACTION || left.is_number()) && (rt == Object::OBJECT_FRACTION || right.is_number()))
+        return eval_fraction_infix_expression(op, Ob_Fraction::of(left), Ob_Fraction::of(right));
 
-    // fraction op bool
-    if (left->type() == Object::OBJECT_FRACTION && right->type() == Object::OBJECT_BOOLEAN)
-        return eval_fraction_infix_expression(op, left, std::make_shared<Ob_Fraction>(right->m_int, 1));
+    // bigint op bigint，bigint op int(bool)，int(bool) op bigint
+    if ((lt == Object::OBJECT_BIGINT || left.is_number()) && (rt == Object::OBJECT_BIGINT || right.is_number()))
+        return eval_bigint_infix_expression(op, Ob_BigInt::of(left), Ob_BigInt::of(right));
 
-    // bool op fraction
-    if (left->type() == Object::OBJECT_BOOLEAN && right->type() == Object::OBJECT_FRACTION)
-        return eval_fraction_infix_expression(op, std::make_shared<Ob_Fraction>(left->m_int, 1), right);
+    // 其余整数与分数的组合（含大整数、大分数）
+    auto rational = [](const Value &value, Object::Type type)
+    {
+        return value.is_number() || type == Object::OBJECT_BIGINT ||
+               type == Object::OBJECT_FRACTION || type == Object::OBJECT_BIGFRACTION;
+    };
+    if (rational(left, lt) && rational(right, rt))
+        return eval_bigfraction_infix_expression(op, Ob_BigFraction::of(left), Ob_BigFraction::of(right));
 
     // string op string
-    if (left->type() == Object::OBJECT_STRING && right->type() == Object::OBJECT_STRING)
+    if (left.type() == Object::OBJECT_STRING && right.type() == Object::OBJECT_STRING)
     {
-        auto l = left->m_string;
-        auto r = right->m_string;
+        auto &l = left->string();
+        auto &r = right->string();
         switch (op)
         {
         case TokenType::PLUS:
-            return std::make_shared<Ob_String>(l + r);
+            return make_object<Ob_String>(l + r);
         case TokenType::EQUAL_EQUAL:
-            return std::make_shared<Ob_Boolean>(l == r);
+            return Value::boolean(l == r);
         case TokenType::BANG_EQUAL:
-            return std::make_shared<Ob_Boolean>(l != r);
+            return Value::boolean(l != r);
         default:
-            throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left->name() + " " +
-                                     TokenTypeToString[op] + " " + right->name());
+            throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left.name() + " " +
+                                     TokenTypeToString[op] + " " + right.name());
         }
     }
     // string op int
-    if (left->type() == Object::OBJECT_STRING && right->type() == Object::OBJECT_INTEGER)
+    if (left.type() == Object::OBJECT_STRING && right.type() == Object::OBJECT_INTEGER)
     {
-        auto l = left->m_string;
-        auto r = right->m_int;
+        auto &l = left->string();
+        auto r = right.m_int;
         std::string result;
         switch (op)
         {
         case TokenType::STAR:
             for (int i = 0; i < r; i++)
                 result += l;
-            return std::make_shared<Ob_String>(result);
+            return make_object<Ob_String>(result);
         case TokenType::DOT:
             if (r < l.length())
-                return std::make_shared<Ob_String>(l[r]);
+                return make_object<Ob_String>(l[r]);
             else
-                throw std::runtime_error("Evaluator::eval_infix: index " + left->str() + " out of length " + std::to_string(l.length()));
+                throw std::runtime_error("Evaluator::eval_infix: index " + left.str() + " out of length " + std::to_string(l.length()));
         default:
-            throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left->name() +
-                                     TokenTypeToString[op] + right->name());
+            throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left.name() +
+                                     TokenTypeToString[op] + right.name());
         }
     }
     // array op array
-    if (left->type() == Object::OBJECT_ARRAY && right->type() == Object::OBJECT_ARRAY)
+    if (left.type() == Object::OBJECT_ARRAY && right.type() == Object::OBJECT_ARRAY)
     {
-        std::string result;
         switch (op)
         {
         case TokenType::PLUS:
-            return std::dynamic_pointer_cast<Ob_Array>(left)->add(std::dynamic_pointer_cast<Ob_Array>(right));
+            return static_cast<Ob_Array *>(left.m_obj)->add(right.m_obj);
         case TokenType::EQUAL_EQUAL:
-            return std::make_shared<Ob_Boolean>(left->m_array == right->m_array);
+            return Value::boolean(left->array() == right->array());
         default:
-            throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left->name() +
-                                     TokenTypeToString[op] + right->name());
+            throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left.name() +
+                                     TokenTypeToString[op] + right.name());
         }
     }
 
-    if (left->type() == Object::OBJECT_ERROR)
+    if (left.type() == Object::OBJECT_ERROR)
         return left;
-    if (right->type() == Object::OBJECT_ERROR)
+    if (right.type() == Object::OBJECT_ERROR)
         return right;
 
-    throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left->name() +
-                             TokenTypeToString[op] + right->name());
+    throw std::runtime_error("Evaluator::eval_infix unknown operation: " + left.name() +
+                             TokenTypeToString[op] + right.name());
 }
 
-std::shared_ptr<Object> Evaluator::eval_integer_infix_expression(const TokenType &op, const std::shared_ptr<Object> &left,
-                                                                 const std::shared_ptr<Object> &right)
+Value Evaluator::eval_integer_infix_expression(const TokenType &op, const Value &left, const Value &right)
 {
-
-    long long &l = left->m_int;
-    long long &r = right->m_int;
+    long long l = left.m_int;
+    long long r = right.m_int;
+    // 算术运算结果沿用左操作数的类型
+    Value result = left;
 
     switch (op)
     {
+    // 溢出时改用大整数计算
     case TokenType::PLUS:
-        left->m_int = l + r;
-        return left;
+        if (__builtin_add_overflow(l, r, &result.m_int))
+            return eval_bigint_infix_expression(op, l, r);
+        return result;
     case TokenType::MINUS:
-        left->m_int = l - r;
-        return left;
+        if (__builtin_sub_overflow(l, r, &result.m_int))
+            return eval_bigint_infix_expression(op, l, r);
+        return result;
     case TokenType::STAR:
-        left->m_int = l * r;
-        return left;
+        if (__builtin_mul_overflow(l, r, &result.m_int))
+            return eval_bigint_infix_expression(op, l, r);
+        return result;
     case TokenType::SLASH:
         if (r == 0)
             throw std::runtime_error("ZeroDivisionError: division by zero");
-        return std::make_shared<Ob_Fraction>(l, r);
+        return Ob_Fraction::make(l, r);
     case TokenType::SLASH_SLASH:
-        left->m_int = l / r;
-        return left;
+        if (r == 0)
+            throw std::runtime_error("ZeroDivisionError: integer division by zero");
+        if (r == -1 && l == LLONG_MIN)
+            return eval_bigint_infix_expression(op, l, r);
+        result.m_int = l / r;
+        return result;
     case TokenType::STAR_STAR:
-        left->m_int = std::pow(l, r);
-        return left;
+        if (r < 0)
+            result.m_int = std::pow(l, r);
+        else if (!BigInt::small_pow(l, r, result.m_int))
+            return eval_bigint_infix_expression(op, l, r);
+        return result;
     case TokenType::PERCENT:
-        left->m_int = l % r;
-        return left;
+        if (r == 0)
+            throw std::runtime_error("ZeroDivisionError: integer modulo by zero");
+        result.m_int = r == -1 ? 0 : l % r;
+        return result;
     case TokenType::DOT: // 分数
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::decimalToFraction(l, r));
+        return Ob_Fraction::make(Rational::decimal(l, r));
     case TokenType::EQUAL_EQUAL:
-        left->m_int = l == r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l == r);
     case TokenType::BANG_EQUAL:
-        left->m_int = l != r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l != r);
     case TokenType::LESS:
-        left->m_int = l < r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l < r);
     case TokenType::GREATER:
-        left->m_int = l > r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l > r);
     case TokenType::LESS_EQUAL:
-        left->m_int = l <= r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l <= r);
     case TokenType::GREATER_EQUAL:
-        left->m_int = l >= r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l >= r);
     case TokenType::SHL:
-        left->m_int = l << r;
-        return left;
+        result.m_int = l << r;
+        return result;
     case TokenType::SHR:
-        left->m_int = l >> r;
-        return left;
+        result.m_int = l >> r;
+        return result;
     case TokenType::BIT_XOR:
-        left->m_int = l ^ r;
-        return left;
+        result.m_int = l ^ r;
+        return result;
     case TokenType::BIT_AND:
-        left->m_int = l & r;
-        return left;
+        result.m_int = l & r;
+        return result;
     case TokenType::BIT_OR:
-        left->m_int = l | r;
-        return left;
+        result.m_int = l | r;
+        return result;
     case TokenType::XOR:
-        left->m_int = l ^ r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l ^ r);
     case TokenType::AND:
-        left->m_int = l && r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l && r);
     case TokenType::OR:
-        left->m_int = l || r;
-        left->m_type = Object::OBJECT_BOOLEAN;
-        return left;
+        return Value::boolean(l || r);
+    default:
+        throw std::runtime_error("Evaluator::eval_integer_infix_expression unknown operation: " + left.name() + TokenTypeToString[op] + right.name());
+    }
+}
+
+Value Evaluator::eval_bigint_infix_expression(const TokenType &op, const BigInt &l, const BigInt &r)
+{
+    switch (op)
+    {
+    case TokenType::PLUS:
+        return Ob_BigInt::make(BigInt::add(l, r));
+    case TokenType::MINUS:
+        return Ob_BigInt::make(BigInt::sub(l, r));
+    case TokenType::STAR:
+        return Ob_BigInt::make(BigInt::mul(l, r));
+    case TokenType::SLASH:
+    {
+        if (r.is_zero())
+            throw std::runtime_error("ZeroDivisionError: division by zero");
+        BigInt quotient, remainder;
+        BigInt::divmod(l, r, quotient, remainder);
+        if (remainder.is_zero())
+            return Ob_BigInt::make(std::move(quotient));
+        return Ob_BigFraction::make(BigRational::reduce(l, r));
+    }
+    case TokenType::SLASH_SLASH:
+        if (r.is_zero())
+            throw std::runtime_error("ZeroDivisionError: integer division by zero");
+        return Ob_BigInt::make(BigInt::div(l, r));
+    case TokenType::PERCENT:
+        if (r.is_zero())
+            throw std::runtime_error("ZeroDivisionError: integer modulo by zero");
+        return Ob_BigInt::make(BigInt::mod(l, r));
+    case TokenType::STAR_STAR:
+        if (r.negative()) // 与 long long 的 std::pow 取整一致：只有 1 和 -1 的结果不为 0
+        {
+            if (BigInt::compare(l, 1) == 0)
+                return Value::integer(1);
+            if (BigInt::compare(l, -1) == 0)
+                return Value::integer(BigInt::mod(r, 2).is_zero() ? 1 : -1);
+            return Value::integer(0);
+        }
+        if (!r.fits_long())
+            throw std::runtime_error("OverflowError: exponent too large");
+        return Ob_BigInt::make(BigInt::pow(l, r.to_long()));
+    case TokenType::EQUAL_EQUAL:
+        return Value::boolean(BigInt::compare(l, r) == 0);
+    case TokenType::BANG_EQUAL:
+        return Value::boolean(BigInt::compare(l, r) != 0);
+    case TokenType::LESS:
+        return Value::boolean(BigInt::compare(l, r) < 0);
+    case TokenType::GREATER:
+        return Value::boolean(BigInt::compare(l, r) > 0);
+    case TokenType::LESS_EQUAL:
+        return Value::boolean(BigInt::compare(l, r) <= 0);
+    case TokenType::GREATER_EQUAL:
+        return Value::boolean(BigInt::compare(l, r) >= 0);
+    case TokenType::AND:
+        return Value::boolean(!l.is_zero() && !r.is_zero());
+    case TokenType::OR:
+        return Value::boolean(!l.is_zero() || !r.is_zero());
+    default:
+        throw std::runtime_error("Evaluator::eval_bigint_infix_expression unknown operation: BigInt " + TokenTypeToString[op] + " BigInt");
+    }
+}
+
+Value Evaluator::eval_fraction_infix_expression(const TokenType &op, const Rational &l, const Rational &r)
+{
+    if ((op == TokenType::SLASH || op == TokenType::SLASH_SLASH || op == TokenType::PERCENT) && r.num == 0)
+        throw std::runtime_error("ZeroDivisionError: fraction division by zero");
+
+    // 结果超出 long long 时改用大分数重新计算
+    Rational result;
+    switch (op)
+    {
+    case TokenType::PLUS:
+        if (!Rational::add(l, r, result))
+            break;
+        return Ob_Fraction::make(result);
+    case TokenType::MINUS:
+        if (!Rational::sub(l, r, result))
+            break;
+        return Ob_Fraction::make(result);
+    case TokenType::STAR:
+        if (!Rational::mul(l, r, result))
+            break;
+        return Ob_Fraction::make(result);
+    case TokenType::SLASH:
+        if (!Rational::div(l, r, result))
+            break;
+        return Ob_Fraction::make(result);
+    case TokenType::SLASH_SLASH:
+        if (!Rational::div(l, r, result))
+            break;
+        return Value::integer(result.num / result.den);
+    case TokenType::STAR_STAR:
+        if (r.den != 1)
+        {
+            double value = std::pow(l.to_float(), r.to_float());
+            if (std::isnan(value))
+                throw std::runtime_error("ValueError: fraction power is not a real number");
+            if (!Rational::from_float(value, result))
+                throw std::runtime_error("OverflowError: fraction power is out of range");
+            return Ob_Fraction::make(result);
+        }
+        if (l.num == 0 && r.num < 0)
+            throw std::runtime_error("ZeroDivisionError: zero to a negative power");
+        if (!Rational::pow(l, r.num, result))
+            break;
+        return Ob_Fraction::make(result);
+    case TokenType::PERCENT:
+        if (!Rational::mod(l, r, result))
+            break;
+        return Ob_Fraction::make(result);
+    case TokenType::EQUAL_EQUAL:
+        return Value::boolean(Rational::compare(l, r) == 0);
+    case TokenType::BANG_EQUAL:
+        return Value::boolean(Rational::compare(l, r) != 0);
+    case TokenType::LESS:
+        return Value::boolean(Rational::compare(l, r) < 0);
+    case TokenType::GREATER:
+        return Value::boolean(Rational::compare(l, r) > 0);
+    case TokenType::LESS_EQUAL:
+        return Value::boolean(Rational::compare(l, r) <= 0);
+    case TokenType::GREATER_EQUAL:
+        return Value::boolean(Rational::compare(l, r) >= 0);
     default:
-        throw std::runtime_error("Evaluator::eval_integer_infix_expression unknown operation: " + left->name() + TokenTypeToString[op] + right->name());
+        throw std::runtime_error("Evaluator::eval_fraction_infix_expression unknown operation: Fraction " + TokenTypeToString[op] + " Fraction");
     }
+    return eval_bigfraction_infix_expression(op, l, r);
 }
 
-std::shared_ptr<Object> Evaluator::eval_fraction_infix_expression(const TokenType &op, const std::shared_ptr<Object> &left,
-                                                                  const std::shared_ptr<Object> &right)
+Value Evaluator::eval_bigfraction_infix_expression(const TokenType &op, const BigRational &l, const BigRational &r)
 {
-    auto l = std::dynamic_pointer_cast<Ob_Fraction>(left);
-    auto r = std::dynamic_pointer_cast<Ob_Fraction>(right);
+    if ((op == TokenType::SLASH || op == TokenType::SLASH_SLASH || op == TokenType::PERCENT) && r.num.is_zero())
+        throw std::runtime_error("ZeroDivisionError: fraction division by zero");
+
     switch (op)
     {
     case TokenType::PLUS:
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::add(l, r));
+        return Ob_BigFraction::make(BigRational::add(l, r));
     case TokenType::MINUS:
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::sub(l, r));
+        return Ob_BigFraction::make(BigRational::sub(l, r));
     case TokenType::STAR:
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::mul(l, r));
+        return Ob_BigFraction::make(BigRational::mul(l, r));
     case TokenType::SLASH:
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::div(l, r));
+        return Ob_BigFraction::make(BigRational::div(l, r));
     case TokenType::SLASH_SLASH:
-        return std::make_shared<Ob_Integer>(Ob_Fraction::div(l, r).m_int);
+    {
+        auto quotient = BigRational::div(l, r);
+        return Ob_BigInt::make(BigInt::div(quotient.num, quotient.den));
+    }
     case TokenType::STAR_STAR:
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::pow(l, r));
+        // 只支持整数次幂，结果是精确的
+        if (BigInt::compare(r.den, 1) != 0 || !r.num.fits_long())
+            throw std::runtime_error("OverflowError: big fraction power needs a small integer exponent");
+        if (!r.num.negative())
+            return Ob_BigFraction::make(BigRational::pow(l, r.num.to_long()));
+        if (l.num.is_zero())
+            throw std::runtime_error("ZeroDivisionError: zero to a negative power");
+        return Ob_BigFraction::make(BigRational::pow(BigRational::reduce(l.den, l.num), -(unsigned long long)r.num.to_long()));
     case TokenType::PERCENT:
-        return std::make_shared<Ob_Fraction>(Ob_Fraction::mod(l, r));
+        return Ob_BigFraction::make(BigRational::mod(l, r));
     case TokenType::EQUAL_EQUAL:
-        return std::make_shared<Ob_Boolean>(l->equal(r));
+        return Value::boolean(BigRational::compare(l, r) == 0);
     case TokenType::BANG_EQUAL:
-        return std::make_shared<Ob_Boolean>(l->notEqual(r));
+        return Value::boolean(BigRational::compare(l, r) != 0);
     case TokenType::LESS:
-        return std::make_shared<Ob_Boolean>(l->lessThan(r));
+        return Value::boolean(BigRational::compare(l, r) < 0);
     case TokenType::GREATER:
-        return std::make_shared<Ob_Boolean>(l->greaterThan(r));
+        return Value::boolean(BigRational::compare(l, r) > 0);
     case TokenType::LESS_EQUAL:
-        return std::make_shared<Ob_Boolean>(l->lessEqual(r));
+        return Value::boolean(BigRational::compare(l, r) <= 0);
     case TokenType::GREATER_EQUAL:
-        return std::make_shared<Ob_Boolean>(l->greaterEqual(r));
+        return Value::boolean(BigRational::compare(l, r) >= 0);
     default:
-        throw std::runtime_error("Evaluator::eval_fraction_infix_expression unknown operation: " + left->name() + TokenTypeToString[op] + right->name());
+        throw std::runtime_error("Evaluator::eval_bigfraction_infix_expression unknown operation: BigFraction " + TokenTypeToString[op] + " BigFraction");
     }
 }
 
-std::shared_ptr<Object> Evaluator::eval_index(std::shared_ptr<Object> &name,
-                                              const std::shared_ptr<Object> &index, Scope &scp)
+Value Evaluator::eval_index(const Value &name, const Value &index)
 {
-    const int idx = index->m_int;
-    if (idx < 0 || idx >= std::dynamic_pointer_cast<Ob_Array>(name)->m_array.size())
+    const long long idx = index.m_int;
+    auto &array = name->array();
+    if (idx < 0 || idx >= (long long)array.size())
         throw std::runtime_error("Evaluator::eval_index: index of " + std::to_string(idx) + " out of range");
-    return std::dynamic_pointer_cast<Ob_Array>(name)->m_array[idx];
+    return array[idx];
 }
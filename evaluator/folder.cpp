@@ -0,0 +1,233 @@
+#include "folder.h"
+#include "evaluator.h"
+
+void Folder::fold_program(const std::shared_ptr<Program> &program, Evaluator &evaluator)
+{
+    if (program->statements().empty())
+        return;
+    m_evaluator = &evaluator;
+    m_arena = program->m_arena.get();
+    fold_statement(*(--program->statements().end()));
+    m_evaluator = nullptr;
+    m_arena = nullptr;
+}
+
+void Folder::fold_statement(const NodeRef<Node> &node)
+{
+    if (!node)
+        return;
+    switch (node->type())
+    {
+    case Node::NODE_EXPRESSION_STATEMENT:
+    {
+        fold_expression(node->expression());
+        return;
+    }
+    case Node::NODE_STATEMENTBLOCK:
+    {
+        for (auto &stat : node->statements())
+        {
+            fold_statement(stat);
+        }
+        return;
+    }
+    case Node::NODE_IFSTATEMENT:
+    {
+        fold_expression(node->expression());
+        fold_statement(node->true_statement());
+        fold_statement(node->false_statement());
+        return;
+    }
+    case Node::NODE_WHILESTATEMENT:
+    {
+        fold_expression(node->expression());
+        fold_statement(node->cycle_statement());
+        return;
+    }
+    case Node::NODE_FUNCTION:
+    {
+        fold_statement(node->statement());
+        return;
+    }
+    case Node::NODE_RETURNSTATEMENT:
+    {
+        fold_statement(node->expression_statement());
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+void Folder::fold_expression(NodeRef<Expression> &node)
+{
+    if (!node)
+        return;
+    switch (node->type())
+    {
+    case Node::NODE_INFIX:
+    {
+        fold_expression(node->m_left);
+        fold_expression(node->m_right);
+        Value value;
+        if (fold_infix(node, value))
+        {
+            auto folded = literal(value);
+            if (folded)
+                node = folded;
+        }
+        return;
+    }
+    case Node::NODE_PREFIX:
+    {
+        fold_expression(node->m_right);
+        Value value;
+        if (fold_prefix(node, value))
+        {
+            auto folded = literal(value);
+            if (folded)
+                node = folded;
+        }
+        return;
+    }
+    case Node::NODE_FUNCTION_IDENTIFIER:
+    {
+        for (auto &arg : node->initial_list())
+        {
+            auto expression = static_node_cast<Expression>(arg);
+            fold_expression(expression);
+            arg = expression;
+        }
+        return;
+    }
+    case Node::NODE_ARRAY:
+    {
+        for (auto &ele : static_node_cast<Array>(node)->m_array)
+        {
+            fold_expression(ele);
+        }
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+bool Folder::constant(const NodeRef<Node> &node, Value &value)
+{
+    switch (node->type())
+    {
+    case Node::NODE_INTEGER:
+        value = Value::integer(node->m_value);
+        return true;
+    case Node::NODE_BOOLEAN:
+        value = Value::boolean(node->m_bool);
+        return true;
+    case Node::NODE_STRING:
+        value = make_object<Ob_String>(node->string());
+        return true;
+    case Node::NODE_FRACTION:
+        value = Ob_Fraction::make(node->m_value, node->den());
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool Folder::fold_infix(const NodeRef<Node> &node, Value &value)
+{
+    TokenType op = node->m_operator;
+    if (op == TokenType::EQUAL || op == TokenType::LEFT_BRACKET)
+        return false;
+    Value left, right;
+    if (!constant(node->m_left, left) || !constant(node->m_right, right))
+        return false;
+
+    // 除数为零时运行时要么报错要么出错，一律留到运行时
+    if (op == TokenType::SLASH || op == TokenType::SLASH_SLASH || op == TokenType::PERCENT)
+    {
+        if (right.is_number() && right.m_int == 0)
+            return false;
+        if (right.type() == Object::OBJECT_FRACTION && Ob_Fraction::of(right).num == 0)
+            return false;
+    }
+
+    // 避免为可能根本不会执行的代码生成过大的字符串
+    if (op == TokenType::STAR && left.type() == Object::OBJECT_STRING && right.is_number() &&
+        right.m_int > 0 && (long long)left->string().size() * right.m_int > MAX_STRING)
+        return false;
+
+    try
+    {
+        value = m_evaluator->eval_infix(op, left, right, m_scope);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool Folder::fold_prefix(const NodeRef<Node> &node, Value &value)
+{
+    Value right;
+    if (!constant(node->m_right, right))
+        return false;
+
+    TokenType op = node->m_operator;
+    try
+    {
+        switch (right.type())
+        {
+        case Object::OBJECT_INTEGER:
+            value = m_evaluator->eval_integer_prefix_expression(op, right);
+            return true;
+        case Object::OBJECT_FRACTION:
+            value = m_evaluator->eval_fraction_prefix_expression(op, right);
+            return true;
+        case Object::OBJECT_BOOLEAN:
+            value = m_evaluator->eval_boolean_prefix_expression(op, right);
+            return true;
+        default:
+            return false;
+        }
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+NodeRef<Expression> Folder::literal(const Value &value)
+{
+    NodeRef<Expression> node;
+    switch (value.type())
+    {
+    case Object::OBJECT_INTEGER:
+        node = m_arena->make<Integer>();
+        node->m_value = value.m_int;
+        break;
+    case Object::OBJECT_BOOLEAN:
+        // 布尔值参与算术后可能不是 0/1，布尔常量节点表示不了
+        if (value.m_int != 0 && value.m_int != 1)
+            return nullptr;
+        node = m_arena->make<Boolean>();
+        node->m_bool = value.m_int;
+        break;
+    case Object::OBJECT_STRING:
+        node = m_arena->make<String>();
+        node->string() = value->string();
+        break;
+    case Object::OBJECT_FRACTION:
+    {
+        Rational fraction = Ob_Fraction::of(value);
+        node = m_arena->make<Fraction>();
+        node->m_value = fraction.num;
+        node->den() = fraction.den;
+        break;
+    }
+    default:
+        return nullptr;
+    }
+    return node;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+#include "scope.h"
+#include "../ast/node.h"
+#include "../ast/statement.h"
+#include "../ast/infix.h"
+
+class Evaluator;
+
+// 常量折叠：把只由整数、字符串、布尔值和分数常量组成的中缀/前缀子树替换为常量节点
+//
+// 折叠时直接调用求值器的运算函数，结果与运行时完全一致；运行时会报错的运算
+// （除以零、类型不匹配等）不折叠，错误仍在执行到那里时抛出。
+class Folder
+{
+public:
+    Folder() {}
+    ~Folder() {}
+
+    void fold_program(const std::shared_ptr<Program> &program, Evaluator &evaluator); // 折叠程序的最后一条语句
+
+private:
+    void fold_statement(const NodeRef<Node> &node);
+    void fold_expression(NodeRef<Expression> &node); // 原地替换可以折叠的子树
+
+    bool constant(const NodeRef<Node> &node, Value &value); // 常量节点的值
+    bool fold_infix(const NodeRef<Node> &node, Value &value);
+    bool fold_prefix(const NodeRef<Node> &node, Value &value);
+    NodeRef<Expression> literal(const Value &value); // 由值生成常量节点（分配在程序的分配区中）
+
+private:
+    static constexpr long long MAX_STRING = 1 << 16; // 折叠生成的字符串长度上限
+
+    Evaluator *m_evaluator = nullptr;
+    Arena *m_arena = nullptr; // 被折叠程序的分配区，只在 fold_program 期间有效
+    Scope m_scope; // 折叠时不会访问变量，仅用于满足接口
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include "../object/object.h"
+
+// 语句块和函数作用域的槽位分配区
+//
+// 作用域按后进先出的顺序创建和销毁，槽位像栈一样分配：进入作用域时移动栈顶，离开时清空槽位并退回。
+// 槽位放在固定大小的块中，块不会移动，作用域存续期间槽位的地址不变；块用完后保留，
+// 之后的作用域（如下一次循环迭代、下一次函数调用）直接复用，不再向系统申请内存。
+// 所有成员都是零初始化的，可以作为静态变量使用。
+class FrameArena
+{
+public:
+    FrameArena() = default;
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+    ~FrameArena()
+    {
+        while (m_chunk && m_chunk->prev)
+            m_chunk = m_chunk->prev;
+        while (m_chunk)
+        {
+            Chunk *next = m_chunk->next;
+            delete[] m_chunk->begin;
+            delete m_chunk;
+            m_chunk = next;
+        }
+    }
+
+    // 分配 n 个空槽位
+    Value *push(size_t n)
+    {
+        if ((size_t)(m_end - m_top) < n)
+            next_chunk(n);
+        Value *base = m_top;
+        m_top += n;
+        return base;
+    }
+
+    // 清空并归还最近分配的 n 个槽位，base 必须是对应的 push 的返回值
+    void pop(Value *base, size_t n)
+    {
+        if (n == 0)
+            return;
+        for (size_t i = 0; i < n; i++)
+            base[i] = Value();
+        while (base < m_chunk->begin || base > m_chunk->end)
+            m_chunk = m_chunk->prev;
+        m_top = base;
+        m_end = m_chunk->end;
+    }
+
+private:
+    struct Chunk
+    {
+        Chunk *prev;
+        Chunk *next;
+        Value *begin;
+        Value *end;
+    };
+
+    // 换到下一块，已有的块太小时在其前面插入新块
+    void next_chunk(size_t n)
+    {
+        Chunk *chunk = m_chunk ? m_chunk->next : nullptr;
+        if (!chunk || (size_t)(chunk->end - chunk->begin) < n)
+        {
+            size_t size = std::max(CHUNK_SLOTS, n);
+            chunk = new Chunk{m_chunk, chunk, new Value[size], nullptr};
+            chunk->end = chunk->begin + size;
+            if (chunk->next)
+                chunk->next->prev = chunk;
+            if (m_chunk)
+                m_chunk->next = chunk;
+        }
+        m_chunk = chunk;
+        m_top = chunk->begin;
+        m_end = chunk->end;
+    }
+
+private:
+    static constexpr size_t CHUNK_SLOTS = 4096;
+
+    Chunk *m_chunk = nullptr; // 栈顶所在的块
+    Value *m_top = nullptr;
+    Value *m_end = nullptr;
+};
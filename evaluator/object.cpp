@@ -1,48 +1,37 @@
 #include "evaluator.h"
 
-std::shared_ptr<Object> Evaluator::eval_identifier(const std::shared_ptr<Node> &node, Scope &scp)
+Value *Evaluator::find_variable(const NodeRef<Node> &node, Scope &scp)
 {
-    auto it = scp.m_var.find(node->m_name);
-    if (it != scp.m_var.end())
+    if (node->m_slot >= 0)
     {
-        return it->second->clone();
+        auto &var = scp.up(node->m_depth)->m_slots[node->m_slot];
+        if (var)
+            return &var;
     }
+    return scp.lookup(node->m_name);
+}
 
-    auto current_scope = &scp;
-    while (current_scope->father != nullptr)
+Value Evaluator::eval_identifier(const NodeRef<Node> &node, Scope &scp)
+{
+    auto var = find_variable(node, scp);
+    if (var)
     {
-        current_scope = current_scope->father;
-        auto it = current_scope->m_var.find(node->m_name);
-        if (it != current_scope->m_var.end())
-        {
-            return it->second->clone();
-        }
+        return *var;
     }
-    auto itt = scp.m_func.find(node->m_name);
-    if (itt != scp.m_func.end())
+    auto function = scp.function(node->m_name);
+    if (function)
     {
-        return std::make_shared<Ob_Funtion>(itt->second);
+        return make_object<Ob_Funtion>(*function);
     }
-    throw std::runtime_error("Evaluator::eval_identifier: identifier '" + identifier_map->find(node->m_name)->second + "' not found");
+    throw std::runtime_error("Evaluator::eval_identifier: identifier '" + std::string(Intern::name(node->m_name)) + "' not found");
 }
 
-std::shared_ptr<Object> Evaluator::eval_identifier_self(const std::shared_ptr<Node> &node, Scope &scp)
+Value Evaluator::eval_identifier_self(const NodeRef<Node> &node, Scope &scp)
 {
-    auto it = scp.m_var.find(node->m_name);
-    if (it != scp.m_var.end())
-    {
-        return it->second;
-    }
-
-    auto current_scope = &scp;
-    while (current_scope->father != nullptr)
+    auto var = find_variable(node, scp);
+    if (var)
     {
-        current_scope = current_scope->father;
-        auto it = current_scope->m_var.find(node->m_name);
-        if (it != current_scope->m_var.end())
-        {
-            return it->second;
-        }
+        return *var;
     }
-    throw std::runtime_error("Evaluator::eval_identifier_self: identifier '" + identifier_map->find(node->m_name)->second + "' not found");
+    throw std::runtime_error("Evaluator::eval_identifier_self: identifier '" + std::string(Intern::name(node->m_name)) + "' not found");
 }
\ No newline at end of file
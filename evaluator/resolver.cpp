@@ -0,0 +1,351 @@
+#include "resolver.h"
+#include <algorithm>
+
+void Resolver::resolve_program(const std::shared_ptr<Program> &program, Scope &global_scp)
+{
+    if (program->statements().empty())
+        return;
+    auto &stat = *(--program->statements().end());
+
+    // 全局作用域的布局可以增长，先为本语句中赋值的名字预留槽位
+    std::vector<int> names;
+    collect_statement(stat, names);
+    for (int name : names)
+    {
+        global_scp.reserve(name);
+    }
+
+    m_frames.clear();
+    m_frames.push_back({SCOPE_GLOBAL, &global_scp.m_names, {}, {}});
+    for (size_t i = 0; i < global_scp.m_names.size(); i++)
+    {
+        if (global_scp.m_slots[i])
+            m_frames.back().definite.insert(global_scp.m_names[i]);
+    }
+    resolve_statement(stat);
+    m_frames.clear();
+}
+
+void Resolver::resolve_statements(const std::vector<NodeRef<Node>> &stmts)
+{
+    for (auto &stat : stmts)
+    {
+        resolve_statement(stat);
+    }
+}
+
+void Resolver::resolve_statement(const NodeRef<Node> &node)
+{
+    if (!node)
+        return;
+    switch (node->type())
+    {
+    case Node::NODE_EXPRESSION_STATEMENT:
+    {
+        resolve_expression(node->expression());
+        return;
+    }
+    case Node::NODE_STATEMENTBLOCK:
+    {
+        resolve_block(node);
+        return;
+    }
+    case Node::NODE_IFSTATEMENT:
+    {
+        resolve_expression(node->expression());
+        auto before = m_frames.back().definite;
+        resolve_statement(node->true_statement());
+        auto after_true = m_frames.back().definite;
+        m_frames.back().definite = before;
+        if (node->false_statement())
+        {
+            resolve_statement(node->false_statement());
+            // 两个分支都赋值过的才一定存在
+            auto &definite = m_frames.back().definite;
+            for (auto it = definite.begin(); it != definite.end();)
+            {
+                if (after_true.count(*it))
+                    ++it;
+                else
+                    it = definite.erase(it);
+            }
+        }
+        return;
+    }
+    case Node::NODE_WHILESTATEMENT:
+    {
+        // 循环会回到条件处，循环体中的赋值在条件和循环体开头都可能已经发生
+        std::vector<int> names;
+        collect_statement(node, names);
+        m_frames.back().possible.insert(names.begin(), names.end());
+        auto before = m_frames.back().definite;
+        resolve_expression(node->expression());
+        resolve_statement(node->cycle_statement());
+        m_frames.back().definite = before;
+        return;
+    }
+    case Node::NODE_FUNCTION:
+    {
+        resolve_function(node);
+        return;
+    }
+    case Node::NODE_RETURNSTATEMENT:
+    {
+        resolve_expression(node->expression_statement()->expression());
+        return;
+    }
+    case Node::NODE_BREAKSTATEMENT:
+    case Node::NODE_CONTINUESTATEMENT:
+    case Node::NODE_COMMENT:
+        return;
+    default:
+        resolve_expression(node);
+    }
+}
+
+void Resolver::resolve_block(const NodeRef<Node> &node)
+{
+    std::vector<int> names;
+    for (auto &stat : node->statements())
+    {
+        collect_statement(stat, names);
+    }
+    // 外层确定已有的名字赋值时不会落在本层，不必占用槽位
+    node->locals().clear();
+    int depth, slot;
+    for (int name : names)
+    {
+        if (lookup(name, m_frames.size(), depth, slot) != FOUND)
+            node->locals().push_back(name);
+    }
+    m_frames.push_back({SCOPE_BLOCK, &node->locals(), {}, {}});
+    resolve_statements(node->statements());
+    m_frames.pop_back();
+}
+
+void Resolver::resolve_function(const NodeRef<Node> &node)
+{
+    // 参数在前，其后是函数体中直接赋值的名字
+    node->locals().clear();
+    for (auto &arg : node->initial_list())
+    {
+        if (std::find(node->locals().begin(), node->locals().end(), arg->m_name) == node->locals().end())
+            node->locals().push_back(arg->m_name);
+    }
+    if (!node->statement())
+        return;
+    for (auto &stat : node->statement()->statements())
+    {
+        collect_statement(stat, node->locals());
+    }
+
+    // 函数体在调用时才知道外层作用域，与声明处的作用域无关
+    std::vector<Frame> outer;
+    outer.swap(m_frames);
+    m_frames.push_back({SCOPE_FUNCTION, &node->locals(), {}, {}});
+    for (auto &arg : node->initial_list())
+    {
+        m_frames.back().definite.insert(arg->m_name);
+    }
+    resolve_statements(node->statement()->statements());
+    m_frames.swap(outer);
+}
+
+void Resolver::resolve_expression(const NodeRef<Node> &node)
+{
+    if (!node)
+        return;
+    switch (node->type())
+    {
+    case Node::NODE_IDENTIFIER:
+    {
+        resolve_read(node);
+        return;
+    }
+    case Node::NODE_INFIX:
+    {
+        if (node->m_operator == TokenType::EQUAL)
+        {
+            if (node->m_left->type() == Node::NODE_IDENTIFIER)
+            {
+                resolve_expression(node->m_right);
+                resolve_assign(node->m_left);
+                return;
+            }
+            if (node->m_left->m_operator == TokenType::LEFT_BRACKET)
+            {
+                resolve_expression(node->m_left->m_left);
+                resolve_expression(node->m_left->m_right);
+                resolve_expression(node->m_right);
+                return;
+            }
+        }
+        resolve_expression(node->m_left);
+        resolve_expression(node->m_right);
+        return;
+    }
+    case Node::NODE_PREFIX:
+    {
+        resolve_expression(node->m_right);
+        return;
+    }
+    case Node::NODE_FUNCTION_IDENTIFIER:
+    {
+        for (auto &arg : node->initial_list())
+        {
+            resolve_expression(arg);
+        }
+        return;
+    }
+    case Node::NODE_ARRAY:
+    {
+        for (auto &ele : static_node_cast<Array>(node)->m_array)
+        {
+            resolve_expression(ele);
+        }
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+void Resolver::resolve_read(const NodeRef<Node> &ident)
+{
+    int depth, slot;
+    if (lookup(ident->m_name, m_frames.size(), depth, slot) == FOUND)
+    {
+        ident->m_depth = depth;
+        ident->m_slot = slot;
+    }
+    else
+    {
+        ident->m_depth = -1;
+        ident->m_slot = -1;
+    }
+}
+
+void Resolver::resolve_assign(const NodeRef<Node> &ident)
+{
+    int name = ident->m_name;
+    auto &frame = m_frames.back();
+    int depth, slot;
+    Result result = lookup(name, m_frames.size(), depth, slot);
+    if (result == FOUND)
+    {
+        ident->m_depth = depth;
+        ident->m_slot = slot;
+        return;
+    }
+
+    // 外层确定没有这个名字时，无论本层是否已有，结果都落在本层的槽位上
+    int outer_depth, outer_slot;
+    if (frame.kind != SCOPE_FUNCTION && frame.possible.count(name) &&
+        lookup(name, m_frames.size() - 1, outer_depth, outer_slot) == ABSENT)
+        result = ABSENT;
+
+    auto it = std::find(frame.layout->begin(), frame.layout->end(), name);
+    if (result == ABSENT && it != frame.layout->end())
+    {
+        ident->m_depth = 0;
+        ident->m_slot = (int)(it - frame.layout->begin());
+        frame.definite.insert(name);
+    }
+    else
+    {
+        ident->m_depth = -1;
+        ident->m_slot = -1;
+    }
+    frame.possible.insert(name);
+}
+
+Resolver::Result Resolver::lookup(int name, size_t from, int &depth, int &slot)
+{
+    for (size_t i = from; i-- > 0;)
+    {
+        auto &frame = m_frames[i];
+        if (frame.definite.count(name))
+        {
+            auto it = std::find(frame.layout->begin(), frame.layout->end(), name);
+            if (it == frame.layout->end())
+                return UNKNOWN;
+            depth = (int)(from - 1 - i);
+            slot = (int)(it - frame.layout->begin());
+            return FOUND;
+        }
+        if (frame.possible.count(name))
+            return UNKNOWN;
+        if (frame.kind == SCOPE_FUNCTION)
+            return UNKNOWN;
+    }
+    return ABSENT;
+}
+
+void Resolver::collect_statement(const NodeRef<Node> &node, std::vector<int> &names)
+{
+    if (!node)
+        return;
+    switch (node->type())
+    {
+    case Node::NODE_EXPRESSION_STATEMENT:
+        collect_expression(node->expression(), names);
+        return;
+    case Node::NODE_IFSTATEMENT:
+        collect_expression(node->expression(), names);
+        collect_statement(node->true_statement(), names);
+        collect_statement(node->false_statement(), names);
+        return;
+    case Node::NODE_WHILESTATEMENT:
+        collect_expression(node->expression(), names);
+        collect_statement(node->cycle_statement(), names);
+        return;
+    case Node::NODE_RETURNSTATEMENT:
+        collect_expression(node->expression_statement()->expression(), names);
+        return;
+    case Node::NODE_STATEMENTBLOCK: // 新的作用域
+    case Node::NODE_FUNCTION:
+    case Node::NODE_BREAKSTATEMENT:
+    case Node::NODE_CONTINUESTATEMENT:
+    case Node::NODE_COMMENT:
+        return;
+    default:
+        collect_expression(node, names);
+    }
+}
+
+void Resolver::collect_expression(const NodeRef<Node> &node, std::vector<int> &names)
+{
+    if (!node)
+        return;
+    switch (node->type())
+    {
+    case Node::NODE_INFIX:
+        if (node->m_operator == TokenType::EQUAL && node->m_left->type() == Node::NODE_IDENTIFIER)
+        {
+            if (std::find(names.begin(), names.end(), node->m_left->m_name) == names.end())
+                names.push_back(node->m_left->m_name);
+            collect_expression(node->m_right, names);
+            return;
+        }
+        collect_expression(node->m_left, names);
+        collect_expression(node->m_right, names);
+        return;
+    case Node::NODE_PREFIX:
+        collect_expression(node->m_right, names);
+        return;
+    case Node::NODE_FUNCTION_IDENTIFIER:
+        for (auto &arg : node->initial_list())
+        {
+            collect_expression(arg, names);
+        }
+        return;
+    case Node::NODE_ARRAY:
+        for (auto &ele : static_node_cast<Array>(node)->m_array)
+        {
+            collect_expression(ele, names);
+        }
+        return;
+    default:
+        return;
+    }
+}
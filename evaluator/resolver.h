@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include "scope.h"
+#include "../ast/node.h"
+#include "../ast/statement.h"
+#include "../ast/infix.h"
+
+// 变量解析：为能静态确定位置的标识符标注 (层数, 槽位)
+//
+// 赋值时沿作用域链查找，找不到才在当前作用域新建，且函数体运行在调用者的作用域之下，
+// 所以只有“确定已存在”的变量才能解析为槽位；其余的（包括函数体里的非参数变量）
+// 仍按名字查找。
+class Resolver
+{
+public:
+    Resolver() {}
+    ~Resolver() {}
+
+    void resolve_program(const std::shared_ptr<Program> &program, Scope &global_scp); // 解析程序的最后一条语句
+
+private:
+    enum Kind
+    {
+        SCOPE_GLOBAL = 0,
+        SCOPE_BLOCK,
+        SCOPE_FUNCTION, // 之外是调用者的作用域，无法静态确定
+    };
+    struct Frame
+    {
+        Kind kind;
+        const std::vector<int> *layout;  // 槽位布局
+        std::unordered_set<int> definite; // 此处一定已存在的变量
+        std::unordered_set<int> possible; // 此处可能已存在的变量
+    };
+    enum Result
+    {
+        FOUND = 0, // 确定位置
+        ABSENT,    // 确定不存在
+        UNKNOWN,   // 无法确定
+    };
+
+    void resolve_statements(const std::vector<NodeRef<Node>> &stmts);
+    void resolve_statement(const NodeRef<Node> &node);
+    void resolve_expression(const NodeRef<Node> &node);
+    void resolve_block(const NodeRef<Node> &node);
+    void resolve_function(const NodeRef<Node> &node);
+    void resolve_read(const NodeRef<Node> &ident);
+    void resolve_assign(const NodeRef<Node> &ident);
+    Result lookup(int name, size_t from, int &depth, int &slot); // 从第 from 层向外查找
+
+    // 收集直接在当前作用域中赋值的名字（不进入语句块和函数体）
+    static void collect_statement(const NodeRef<Node> &node, std::vector<int> &names);
+    static void collect_expression(const NodeRef<Node> &node, std::vector<int> &names);
+
+private:
+    std::vector<Frame> m_frames;
+};
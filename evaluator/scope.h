@@ -1,50 +1,256 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <vector>
 #include <unordered_map>
 #include <set>
 #include "../object/object.h"
 #include "../ast/statement.h"
+#include "frames.h"
 
 class Scope
 {
 public:
-    Scope(std::unordered_map<int, std::shared_ptr<Object>> var,
-          std::unordered_map<int, std::shared_ptr<Node>> func)
-        : m_var(var), m_func(func) {}
     Scope(Scope *father) : father(father) {}
+    // 有固定布局的作用域（语句块、函数）从 frames 中分配槽位，必须按后进先出的顺序销毁
+    Scope(Scope *father, const std::vector<int> *layout)
+        : father(father), m_layout(layout), m_size(layout->size()), m_slots(frames.push(m_size)) {}
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
 
     Scope() {}
     ~Scope()
     {
-        for (auto it : m_var)
+        if (m_layout)
+            frames.pop(m_slots, m_size);
+        if (!m_tables)
+            return;
+        m_tables->vars.clear();
+        for (auto &func : m_tables->funcs)
+            function_epoch(func.first)++;
+    };
+
+    // 槽位对应的名字
+    const std::vector<int> &names() const { return m_layout ? *m_layout : m_names; }
+
+    // 名字对应的槽位，没有则返回 -1
+    int slot_of(int name) const
+    {
+        if (!m_layout)
+            return name < (int)m_index.size() ? m_index[name] : -1;
+        auto &ns = *m_layout;
+        for (size_t i = 0; i < ns.size(); i++)
         {
-            it.second.reset();
+            if (ns[i] == name)
+                return (int)i;
         }
-        m_var.clear();
-    };
-    void print(std::unordered_map<int, std::string> *var_map, std::unordered_map<int, std::string> *func_map)
+        return -1;
+    }
+
+    // 为名字预留槽位，只有没有固定布局的作用域（全局）可以增长
+    int reserve(int name)
+    {
+        int slot = slot_of(name);
+        if (slot >= 0 || m_layout)
+            return slot;
+        if (name >= (int)m_index.size())
+            m_index.resize(name + 1, -1);
+        m_index[name] = (int)m_size;
+        m_names.push_back(name);
+        m_storage.emplace_back();
+        m_slots = m_storage.data();
+        return (int)m_size++;
+    }
+
+    // 在本层按名字查找
+    Value *find(int name)
+    {
+        int slot = slot_of(name);
+        if (slot >= 0 && m_slots[slot])
+            return &m_slots[slot];
+        if (!m_tables)
+            return nullptr;
+        auto it = m_tables->vars.find(name);
+        return it != m_tables->vars.end() ? &it->second : nullptr;
+    }
+
+    // 在本层按名字查找函数
+    std::shared_ptr<Node> *function(int name)
+    {
+        if (!m_tables)
+            return nullptr;
+        auto it = m_tables->funcs.find(name);
+        return it != m_tables->funcs.end() ? &it->second : nullptr;
+    }
+
+    // 沿作用域链按名字查找
+    Value *lookup(int name)
+    {
+        for (Scope *scp = this; scp != nullptr; scp = scp->father)
+        {
+            auto var = scp->find(name);
+            if (var)
+                return var;
+        }
+        return nullptr;
+    }
+
+    // 在本层新建变量
+    void define(int name, const Value &value)
+    {
+        int slot = reserve(name);
+        if (slot >= 0)
+            m_slots[slot] = value;
+        else
+            vars()[name] = value;
+    }
+
+    // 在本层声明函数（表项持有函数所在的分配区），调用同名函数的调用点缓存随之失效
+    void declare(int name, const NodeRef<Node> &function)
+    {
+        funcs().insert(std::make_pair(name, Function::retain(function)));
+        function_epoch(name)++;
+    }
+
+    // 尾调用复用本层：改用新的布局，原槽位中的变量改为按名字存放
+    //
+    // 此时内层作用域都已销毁，本层的槽位位于 frames 的栈顶，可以直接换成新布局大小的槽位。
+    void relayout(const std::vector<int> *layout)
+    {
+        if (layout == m_layout)
+            return;
+        auto &ns = names();
+        for (size_t i = 0; i < ns.size(); i++)
+        {
+            if (m_slots[i])
+                vars()[ns[i]] = std::move(m_slots[i]);
+        }
+        frames.pop(m_slots, m_size);
+        m_layout = layout;
+        m_size = layout->size();
+        m_slots = frames.push(m_size);
+        if (!m_tables)
+            return;
+        auto &vs = m_tables->vars;
+        for (size_t i = 0; i < layout->size(); i++)
+        {
+            auto it = vs.find((*layout)[i]);
+            if (it == vs.end())
+                continue;
+            m_slots[i] = std::move(it->second);
+            vs.erase(it);
+        }
+    }
+
+    // 尾调用前把从本层到 frame（不含）之间的作用域并入 frame，内层的同名变量和函数优先
+    //
+    // 被调函数原本会运行在这些作用域之下，它们在调用返回前不会再被使用，
+    // 所以合并后按名字查找和赋值的结果与不合并时相同。
+    void collapse_into(Scope *frame)
+    {
+        std::vector<Scope *> inner;
+        for (Scope *scp = this; scp != frame; scp = scp->father)
+            inner.push_back(scp);
+        for (auto it = inner.rbegin(); it != inner.rend(); ++it)
+        {
+            Scope *scp = *it;
+            auto &ns = scp->names();
+            for (size_t i = 0; i < ns.size(); i++)
+            {
+                if (scp->m_slots[i])
+                    frame->define(ns[i], std::move(scp->m_slots[i]));
+            }
+            if (!scp->m_tables)
+                continue;
+            for (auto &var : scp->m_tables->vars)
+                frame->define(var.first, std::move(var.second));
+            for (auto &func : scp->m_tables->funcs)
+            {
+                frame->funcs()[func.first] = func.second;
+                function_epoch(func.first)++;
+            }
+        }
+    }
+
+    // 向外第 depth 层作用域
+    Scope *up(int depth)
+    {
+        Scope *scp = this;
+        while (depth-- > 0)
+            scp = scp->father;
+        return scp;
+    }
+
+    void print()
     {
         std::cout << "Scope: " << std::endl;
-        for (const auto &var : m_var)
+        auto &ns = names();
+        for (size_t i = 0; i < ns.size(); i++)
         {
-            std::cout << "Variable: " << var_map->find(var.first)->second << " = " << var.second->str() << std::endl;
+            if (m_slots[i])
+                std::cout << "Variable: " << Intern::name(ns[i]) << " = " << m_slots[i].str() << std::endl;
+        }
+        if (!m_tables)
+            return;
+        for (const auto &var : m_tables->vars)
+        {
+            std::cout << "Variable: " << Intern::name(var.first) << " = " << var.second.str() << std::endl;
         }
 
-        for (const auto &func : m_func)
+        for (const auto &func : m_tables->funcs)
         {
-            std::cout << "Function: " << func_map->find(func.first)->second << "(";
-            for (int i = 0; i < func.second->m_initial_list.size() - 1; i++)
+            std::cout << "Function: " << Intern::name(func.first) << "(";
+            auto &params = func.second->initial_list();
+            for (size_t i = 0; i < params.size(); i++)
             {
-                std::cout << func.second->m_initial_list[i]->m_name << ", ";
+                std::cout << (i ? ", " : "") << Intern::name(params[i]->m_name);
             }
-            std::cout << func.second->m_initial_list[func.second->m_initial_list.size() - 1]->m_name
-                      << ")" << std::endl;
+            std::cout << ")" << std::endl;
         }
     }
 
 public:
     Scope *father = nullptr;
-    std::unordered_map<int, std::shared_ptr<Object>> m_var;
-    std::unordered_map<int, std::shared_ptr<Node>> m_func;
+    const std::vector<int> *m_layout = nullptr;     // 解析器给出的固定布局
+    std::vector<int> m_names;                       // 无固定布局时自行增长的布局
+    std::vector<int> m_index;                       // 无固定布局时以名字编号为下标的槽位，-1 表示没有
+    size_t m_size = 0;                              // 槽位数
+    Value *m_slots = nullptr;                       // 按槽位存放的变量，有固定布局时位于 frames 中
+    std::vector<Value> m_storage;                   // 无固定布局时槽位的存储
+
+private:
+    // 按名字存放的变量和函数，多数语句块和函数调用用不到，第一次使用时才创建
+    struct Tables
+    {
+        std::unordered_map<int, Value> vars;                   // 布局之外的变量
+        std::unordered_map<int, std::shared_ptr<Node>> funcs; // 本层声明的函数
+    };
+
+    std::unordered_map<int, Value> &vars()
+    {
+        if (!m_tables)
+            m_tables = std::make_unique<Tables>();
+        return m_tables->vars;
+    }
+    std::unordered_map<int, std::shared_ptr<Node>> &funcs()
+    {
+        if (!m_tables)
+            m_tables = std::make_unique<Tables>();
+        return m_tables->funcs;
+    }
+
+    std::unique_ptr<Tables> m_tables;
+
+public:
+    // 名字的函数版本：声明该名字的函数或销毁声明过它的作用域时递增，调用点缓存据此失效
+    static long long &function_epoch(int name)
+    {
+        if (name >= (int)function_epochs.size())
+            function_epochs.resize(std::max(name + 1, Intern::size()), 0);
+        return function_epochs[name];
+    }
+    inline static std::vector<long long> function_epochs; // 以名字编号为下标
+
+    inline static FrameArena frames; // 所有有固定布局的作用域共用的槽位分配区
 };
@@ -1,16 +1,16 @@
 #include "evaluator.h"
 
-std::shared_ptr<Object> Evaluator::eval_statement_block(const std::vector<std::shared_ptr<Node>> &stmts, Scope &scp)
+Value Evaluator::eval_statement_block(const NodeRef<Node> &node, Scope &scp)
 {
-    std::shared_ptr<Object> result = nullptr;
-    Scope temp_scope(&scp);
-    for (auto &stat : stmts)
+    Value result = nullptr;
+    Scope temp_scope(&scp, &node->locals());
+    for (auto &stat : node->statements())
     {
         result = eval(stat, temp_scope);
         if (result)
         {
-            if (result->type() == Object::OBJECT_BREAK || result->type() == Object::OBJECT_CONTINUE ||
-                result->type() == Object::OBJECT_RETURN)
+            if (result.type() == Object::OBJECT_BREAK || result.type() == Object::OBJECT_CONTINUE ||
+                result.type() == Object::OBJECT_RETURN)
             {
                 return result;
             }
@@ -19,85 +19,109 @@ std::shared_ptr<Object> Evaluator::eval_statement_block(const std::vector<std::s
     return result;
 }
 
-std::shared_ptr<Object> Evaluator::eval_function_block(const std::shared_ptr<Node> function,
-                                                       std::shared_ptr<Node> node, Scope &scp)
+Value Evaluator::eval_function_block(std::shared_ptr<Node> function,
+                                                       NodeRef<Node> node, Scope &scp)
 {
-    Scope temp_scp(&scp);
-    if (function->m_initial_list.size() != node->m_initial_list.size())
+    if (function->initial_list().size() != node->initial_list().size())
     {
         throw std::runtime_error("Evaluator::eval_function: function arguments not match");
     }
 
-    for (int i = 0; i < function->m_initial_list.size(); i++)
+    // 实参在调用者的作用域中求值
+    std::vector<Value> args;
+    args.reserve(node->initial_list().size());
+    for (auto &arg : node->initial_list())
     {
-        auto name = function->m_initial_list[i]->m_name;
+        args.push_back(eval(arg, scp));
+    }
 
-        auto it = temp_scp.m_var.find(name);
-        if (it != temp_scp.m_var.end())
-        {
-            it->second = eval(node->m_initial_list[i], temp_scp);
-        }
-        temp_scp.m_var.insert(std::make_pair(name, eval(node->m_initial_list[i], temp_scp)));
+    Scope temp_scp(&scp, &function->locals());
+    for (size_t i = 0; i < function->initial_list().size(); i++)
+    {
+        temp_scp.define(function->initial_list()[i]->m_name, args[i]);
     }
 
-    std::shared_ptr<Object> result;
-    for (auto &stat : function->m_statement->m_statements)
+    Scope *caller = m_frame;
+    m_frame = &temp_scp;
+    Value result;
+    try
     {
-        result = eval(stat, temp_scp);
-        if (result)
+        while (true)
         {
-            if (result->type() == Object::OBJECT_BREAK || result->type() == Object::OBJECT_CONTINUE)
+            for (auto &stat : function->statement()->statements())
             {
-                return nullptr;
+                result = eval(stat, temp_scp);
+                if (result && (result.type() == Object::OBJECT_BREAK || result.type() == Object::OBJECT_CONTINUE ||
+                               result.type() == Object::OBJECT_RETURN))
+                    break;
             }
-            if (result->type() == Object::OBJECT_RETURN)
+            if (!result || result != m_tail_call)
+                break;
+
+            // 尾调用：在本层作用域中重新开始执行被调函数
+            function = std::move(m_tail_function);
+            temp_scp.relayout(&function->locals());
+            size_t base = m_tail_args.size() - function->initial_list().size();
+            for (size_t i = 0; i < function->initial_list().size(); i++)
             {
-                return std::dynamic_pointer_cast<Ob_Return>(result)->m_expression;
+                temp_scp.define(function->initial_list()[i]->m_name, std::move(m_tail_args[base + i]));
             }
+            m_tail_args.resize(base);
         }
     }
+    catch (...)
+    {
+        m_frame = caller;
+        throw;
+    }
+    m_frame = caller;
+
+    if (result && result.type() == Object::OBJECT_RETURN)
+    {
+        return std::move(m_return_value);
+    }
     return nullptr;
 }
 
-std::shared_ptr<Object> Evaluator::eval_function_declaration(const std::shared_ptr<Node> &node, Scope &scp)
+Value Evaluator::eval_function_declaration(const NodeRef<Node> &node, Scope &scp)
 {
-    scp.m_func.insert(std::make_pair((node->m_func)->m_name, node));
+    scp.declare(node->func()->m_name, node);
     return nullptr;
 }
 
-std::shared_ptr<Object> Evaluator::eval_if_statement(const std::shared_ptr<Node> &node, Scope &scp)
+Value Evaluator::eval_if_statement(const NodeRef<Node> &node, Scope &scp)
 {
-    if (eval(node->m_expression, scp)->m_int)
+    if (eval(node->expression(), scp).m_int)
     {
-        auto result = eval(node->m_true_statement, scp);
+        auto result = eval(node->true_statement(), scp);
         return result;
     }
-    else if (node->m_false_statement)
+    else if (node->false_statement())
     {
-        auto result = eval(node->m_false_statement, scp);
+        auto result = eval(node->false_statement(), scp);
         return result;
     }
     return nullptr;
 }
 
-std::shared_ptr<Object> Evaluator::eval_while_statement(const std::shared_ptr<Node> &exp, const std::shared_ptr<Node> true_statement, Scope &scp)
+Value Evaluator::eval_while_statement(const NodeRef<Node> &exp, const NodeRef<Node> true_statement, Scope &scp)
 {
     auto s = eval(exp, scp);
 
-    while (s->m_int)
+    while (s.m_int)
     {
-        std::shared_ptr<Object> result = eval(true_statement, scp);
+        Value result = eval(true_statement, scp);
         if (result)
         {
-            if (result->type() == Object::OBJECT_BREAK)
+            if (result.type() == Object::OBJECT_BREAK)
             {
                 return nullptr;
             }
-            if (result->type() == Object::OBJECT_CONTINUE)
+            if (result.type() == Object::OBJECT_CONTINUE)
             {
                 continue;
             }
-            if (result->type() == Object::OBJECT_RETURN)
+            if (result.type() == Object::OBJECT_RETURN)
             {
                 return result;
             }
@@ -108,63 +132,37 @@ std::shared_ptr<Object> Evaluator::eval_while_statement(const std::shared_ptr<No
     return nullptr;
 }
 
-std::shared_ptr<Object> Evaluator::eval_return_statement(const std::shared_ptr<Node> &node, Scope &scp)
-{
-    return std::make_shared<Ob_Return>(eval(std::dynamic_pointer_cast<ReturnStatement>(node)->m_expression_statement, scp));
-}
-
-std::shared_ptr<Object> Evaluator::eval_append(const std::shared_ptr<Node> &node, Scope &scp)
-{
-    if (node->m_initial_list.size() != 2)
-        throw std::invalid_argument("Evaluator:eval_function: function append arguments not match");
-    else
-    {
-        auto ele = eval(node->m_initial_list[1], scp);
-        auto array = eval_array(node->m_initial_list[0], scp);
-        array->m_array.push_back(ele);
-        return nullptr;
-    }
-}
-
-std::shared_ptr<Object> Evaluator::eval_pop(const std::shared_ptr<Node> &node, Scope &scp)
+Value Evaluator::eval_return_statement(const NodeRef<Node> &node, Scope &scp)
 {
-    if (node->m_initial_list.size() != 1)
-        throw std::invalid_argument("Evaluator:eval_function: function pop arguments not match");
-    else
+    // 函数体中 return 用户函数调用：求出实参后交给当前函数调用复用作用域执行
+    auto &call = node->expression_statement()->expression();
+    if (m_frame && call && call->type() == Node::NODE_FUNCTION_IDENTIFIER)
     {
-        auto array = eval_array(node->m_initial_list[0], scp);
-        if (array->m_array.empty())
-            throw std::runtime_error("Evaluator:eval_pop: pop from empty array");
-        auto top = array->m_array.back();
-        array->m_array.pop_back();
-        return top;
+        auto &site = static_cast<FunctionIdentifier &>(*call);
+        if (site.m_call_epoch != Scope::function_epoch(site.m_name))
+            resolve_call(site, scp);
+        if (site.m_callee)
+        {
+            auto function = *site.m_callee;
+            if (function->initial_list().size() != call->initial_list().size())
+                throw std::runtime_error("Evaluator::eval_function: function arguments not match");
+            // 实参求值时可能发生嵌套的尾调用，所以实参按栈的方式压入，由接手的调用取走
+            for (auto &arg : call->initial_list())
+            {
+                m_tail_args.push_back(eval(arg, scp));
+            }
+            scp.collapse_into(m_frame);
+            m_tail_function = std::move(function);
+            return m_tail_call;
+        }
     }
+    // 返回值求出后才记下，求值过程中的嵌套调用不会覆盖它
+    m_return_value = eval(node->expression_statement(), scp);
+    return m_return;
 }
 
-std::shared_ptr<Object> Evaluator::eval_int(const std::shared_ptr<Node> &node, Scope &scp)
-{
-    if (node->m_initial_list.size() != 1)
-        throw std::invalid_argument("Evaluator:eval_function: function append arguments not match");
-    auto obj = eval(node->m_initial_list[0], scp);
-    switch (obj->type())
-    {
-    case Object::OBJECT_INTEGER:
-        return obj;
-    case Object::OBJECT_FRACTION:
-        return std::make_shared<Ob_Integer>(obj->m_int);
-    case Object::OBJECT_BOOLEAN:
-        return std::make_shared<Ob_Integer>(obj->m_int);
-    case Object::OBJECT_STRING:
-    {
-        std::shared_ptr<Ob_Integer> newint;
-        return std::make_shared<Ob_Integer>(std::stoll(obj->m_string));
-    }
-    default:
-        throw std::runtime_error("Evaluator:eval_function: can not convert " + obj->name() + " to Integer");
-    }
-}
 /*
-std::shared_ptr<Object> Evaluator::eval_ast()
+Value Evaluator::eval_ast()
 {
     rapidjson::Document root;
     root.SetObject();
@@ -172,33 +170,6 @@ std::shared_ptr<Object> Evaluator::eval_ast()
     rapidjson::StringBuffer buffer;
     rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
     root.Accept(writer);
-    return std::make_shared<Ob_String>(buffer.GetString());
+    return make_object<Ob_String>(buffer.GetString());
     //std::cout << "\033[32m" << "AST output to ast.jsonヾ(✿ﾟ▽ﾟ)ノ" << "\033[0m" << std::endl;
 }*/
-void read(char *inpt)
-{
-    int len = 0;
-    char c = getchar();
-    while (c == ' ')
-        c = getchar();
-    inpt[len++] = c;
-    while (1)
-    {
-        c = getchar();
-        if (c == '\n')
-            break;
-        inpt[len++] = c;
-    }
-    inpt[len] = '\0';
-}
-
-std::shared_ptr<Object> Evaluator::eval_input(const std::shared_ptr<Node> &node, Scope &scp)
-{
-    if (node->m_initial_list.size() != 1)
-        throw std::invalid_argument("Evaluator:eval_function: function append arguments not match");
-    std::shared_ptr<Object> otpt = eval(node->m_initial_list[0], scp);
-    std::cout << (otpt->m_string);
-    char inpt[1024];
-    read(inpt);
-    return std::make_shared<Ob_String>(inpt);
-}
\ No newline at end of file
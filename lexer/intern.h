@@ -0,0 +1,57 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 符号表：每个不同的名字驻留为一个从 0 开始的连续编号
+//
+// 编号互不冲突，可以直接作为数组下标；名字只保存一份副本，Token 中的标识符指向这份副本，在整个进程中有效。
+// 编号 0 留给空名字（不是标识符的 Token 的编号）。
+class Intern
+{
+public:
+    struct Name
+    {
+        std::string_view text; // 驻留的副本
+        int id;                // 名字的编号
+    };
+
+    static Name get(std::string_view text)
+    {
+        auto &s = state();
+        auto it = s.table.find(text);
+        if (it != s.table.end())
+            return {it->first, it->second};
+        // deque 追加元素时不移动已有元素，副本的地址保持不变
+        std::string_view copy = s.names.emplace_back(text);
+        int id = (int)s.names.size() - 1;
+        s.table.emplace(copy, id);
+        return {copy, id};
+    }
+
+    static int id(std::string_view text) { return get(text).id; }
+
+    // 编号对应的名字
+    static std::string_view name(int id)
+    {
+        auto &names = state().names;
+        return id >= 0 && id < (int)names.size() ? std::string_view(names[id]) : std::string_view();
+    }
+
+    static int size() { return (int)state().names.size(); } // 已有的编号数
+
+private:
+    struct State
+    {
+        std::deque<std::string> names;                   // 按编号存放的名字
+        std::unordered_map<std::string_view, int> table; // 名字到编号
+        State() { table.emplace(names.emplace_back(), 0); }
+    };
+
+    static State &state()
+    {
+        static State s;
+        return s;
+    }
+};
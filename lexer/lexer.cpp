@@ -1,11 +1,12 @@
 #include "lexer.h"
+#include "scan.h"
 
 const char *Lexer::keywords[9] = {"main", "int", "float", "return", "while", "break", "continue", "if", "else"}; // 保留字
 const char *Lexer::cal_sign[7] = {"+", "-", "*", "/", "%", "^", "&"};                                            // 运算符
 const char *Lexer::space_word_table[8] = {";", ",", "[", "]", "{", "}", "(", ")"};                               // 界限符
 const char *Lexer::relation_calcu_table[7] = {"<", "<=", ">", ">=", "=", "=="};
 
-static std::unordered_map<std::string, TokenType> keyWords = {
+static std::unordered_map<std::string_view, TokenType> keyWords = {
     {"and", TokenType::AND},
     {"or", TokenType::OR},
     {"xor", TokenType::XOR},
@@ -29,21 +30,75 @@ static std::unordered_map<std::string, TokenType> keyWords = {
     {"ERR", TokenType::ERR},
 };
 
-std::vector<Token> Lexer::scanTokens(std::string source)
+const std::vector<Token> &Lexer::scanTokens(const std::string &source)
 {
     tokens.clear();
+    this->source = lines.emplace_back(source); // 多行语句的 Token 会跨行保留，行要一直保存
+    int length = source.length();
+    try
+    {
+        while (current < length)
+        {
+            scanToken(nextChar());
+        }
+    }
+    catch (const std::exception &)
+    {
+        // 调用方丢弃未结束的语句，扫描位置和括号计数也一并清零
+        current = 0;
+        read_current = 0;
+        braceStatus = 0;
+        bracketFix = 0;
+        throw;
+    }
+    current = 0;
+    read_current = 0;
+    size = (int)tokens.size();
+    return tokens;
+}
+
+const std::vector<Token> &Lexer::scanSource(std::string_view source)
+{
+    tokens.clear();
+    statementEnds.clear();
+    errors.clear();
     this->source = source;
+    line = 1;
+    braceStatus = 0;
+    bracketFix = 0;
     int length = source.length();
     while (current < length)
     {
-        scanToken(nextChar());
+        try
+        {
+            scanToken(nextChar());
+        }
+        catch (const std::exception &e)
+        {
+            // 与逐行执行时一样丢弃未结束的语句，括号计数也一并清零，从下一行继续
+            errors.push_back({line, statementEnds.size(), e.what()});
+            tokens.resize(statementEnds.empty() ? 0 : statementEnds.back());
+            braceStatus = 0;
+            bracketFix = 0;
+            while (current < length && source[current] != '\n')
+                current++;
+        }
     }
+    endLine();
     current = 0;
     read_current = 0;
     size = (int)tokens.size();
     return tokens;
 }
 
+void Lexer::endLine()
+{
+    size_t begin = statementEnds.empty() ? 0 : statementEnds.back();
+    if (braceStatus == 0 && tokens.size() > begin &&
+        (tokens.back().type == TokenType::SEMICOLON || tokens.back().type == TokenType::RIGHT_BRACE))
+        statementEnds.push_back(tokens.size());
+}
+
 void Lexer::scanToken(char inpt)
 {
 
@@ -53,10 +108,13 @@ void Lexer::scanToken(char inpt)
         addToken(EOF_TOKEN);
         break;
     case ' ':
-        break;
     case '\t':
+    case '\r':
+        // 连续的空白一次跳过
+        current += Scan::run<Scan::SPACE>(source.data() + current, source.size() - current);
         break;
     case '\n':
+        endLine();
         line++;
         break;
     case '(':
@@ -230,16 +288,14 @@ void Lexer::scanToken(char inpt)
     case '&':
         addToken(BIT_AND);
         break;
-    case '\r':
-        break;
     default:
         switch (findType(inpt))
         {
         case 1:
-            tokens.push_back(tokenLetter(inpt));
+            tokens.push_back(tokenLetter());
             break;
         case 3:
-            tokens.push_back(tokenNumber(inpt));
+            tokens.push_back(tokenNumber());
             break;
         default:
             // 如果使用↓，可以欣赏内存越界的美丽
@@ -265,7 +321,11 @@ void Lexer::addToken(TokenType type)
 
 inline char Lexer::nextChar()
 {
-
+    if (current >= (int)source.size())
+    {
+        current++; // 读到末尾时返回 '\0'，调用方回退一个字符
+        return '\0';
+    }
     unsigned char c = static_cast<unsigned char>(source[current++]);
     if (c >= 0x80)
     {
@@ -338,26 +398,22 @@ int Lexer::isKeywords(char *kw)
 
 Token Lexer::tokenString()
 {
-    std::string string;
-    char inpt = this->nextChar();
-    while (inpt != '"')
-    {
-        string += inpt;
-        inpt = this->nextChar();
-    }
-
-    return Token(TokenType::STRING, string, line);
+    int begin = current;
+    current += Scan::run<Scan::STRING>(source.data() + current, source.size() - current);
+    if (current < (int)source.size() && source[current] & 0x80)
+        this->nextChar(); // 非 ASCII 字符，报错
+    if (current >= (int)source.size() || source[current] == '\n')
+        throw std::runtime_error("Error: unterminated string"); // 换行留给下一行处理
+    current++;
+
+    return Token(TokenType::STRING, source.substr(begin, current - 1 - begin), line);
 }
 
-Token Lexer::tokenLetter(char inpt)
+Token Lexer::tokenLetter()
 {
-    std::string letters;
-    while (isNumber(inpt) || isLetter(inpt) || inpt == '_')
-    {
-        letters += inpt;
-        inpt = this->nextChar();
-    }
-    current--;
+    int begin = current - 1;
+    current += Scan::run<Scan::WORD>(source.data() + current, source.size() - current);
+    auto letters = source.substr(begin, current - begin);
 
     auto it = keyWords.find(letters); // 查找输入字符串
 
@@ -369,26 +425,24 @@ Token Lexer::tokenLetter(char inpt)
     else
     {
         // 没有找到
-        return Token(TokenType::IDENTIFIER, letters, line);
+        auto name = Intern::get(letters);
+        return Token(TokenType::IDENTIFIER, name.text, line, name.id);
     }
 }
 
-Token Lexer::tokenNumber(char inpt)
+Token Lexer::tokenNumber()
 {
-    std::string digits;
-    while (isNumber(inpt))
-    {
-        digits.push_back(inpt);
-        inpt = this->nextChar();
-    }
-    current--;
-    // fseek(file, -1, SEEK_CUR);
-    if (digits.size() > 18)
+    int begin = current - 1;
+    current += Scan::run<Scan::DIGIT>(source.data() + current, source.size() - current);
+    if (current - begin > 18)
+        throw std::runtime_error("Error: " + std::string(source.substr(begin, current - begin)) +
+                                 " out of number MAX(999999999999999999)");
+    long long value = 0;
+    for (int i = begin; i < current; i++)
     {
-        std::cerr << digits << "[error:out_of_number_MAX(999999999999999999)]" << std::endl;
-        return Token(TokenType::ERR, std::monostate(), line);
+        value = value * 10 + (source[i] - '0');
     }
-    return Token(TokenType::INTEGER, std::stoll(digits), line);
+    return Token(TokenType::INTEGER, value, line);
 }
 
 void Lexer::processLetter(char inpt) // 处理字母
@@ -2,9 +2,12 @@
 #include <iostream>
 #include <stdio.h>
 #include <cstring>
+#include <string_view>
 #include <vector>
+#include <deque>
 #include <unordered_map>
 #include "token.h"
+#include "intern.h"
 
 class Lexer
 {
@@ -14,20 +17,32 @@ public:
     static const char *space_word_table[8];     // 界限符
     static const char *relation_calcu_table[7]; // 比较运算符
 
-    std::string source;
+    std::string_view source;   // 正在扫描的源码，由调用方持有
     std::vector<Token> tokens; // 保存 Token 的列表
     // {} [] ()括号数量
     int braceStatus = 0;
     // assign 修正
     int bracketFix = 0;
 
+    // 整个文件扫描时的词法错误：出错的行丢弃，前面未结束的语句一并丢弃
+    struct Error
+    {
+        int line;         // 出错的行号
+        size_t statement; // 出错时已结束的语句数
+        std::string message;
+    };
+    std::vector<size_t> statementEnds; // 整个文件扫描时，每条顶层语句结束后的 Token 下标
+    std::vector<Error> errors;         // 整个文件扫描时的词法错误
+    std::deque<std::string> lines;     // 逐行扫描时读入的行，Token 中的字符串指向这里
+
     Lexer() {}
-    Lexer(const std::string &source) : source(source) {}
 
     // 返回下一个Token
     Token nextToken();
     // 读取一行代码，返回 Token 列表
-    std::vector<Token> scanTokens(std::string source);
+    const std::vector<Token> &scanTokens(const std::string &source);
+    // 一次扫描整个文件，Token 带有正确的行号，并按顶层语句切分
+    const std::vector<Token> &scanSource(std::string_view source);
 
 private:
     int start = 0;
@@ -37,6 +52,7 @@ private:
     int size = 0; // 字符数
 
     void scanToken(char inpt);                  // 读取一个 Token
+    void endLine();                             // 行末：顶层语句已完整时记下结束位置
     char nextChar();                            // 读取下一个字符
     void addToken(TokenType type);              // 添加 Token
     bool isEmpty(char inpt);                    // 读取字符是否为空
@@ -47,8 +63,8 @@ private:
     bool isDelimiter(char inpt);                // 读取字符是否为界限符
     int findType(char inpt);                    // 判断是读取字符是哪一种类型
     int isKeywords(char *kw);                   // 判断字符串是否是关键字
-    Token tokenLetter(char inpt);               // 读取字母
-    Token tokenNumber(char inpt);               // 读取数字
+    Token tokenLetter();                        // 读取字母
+    Token tokenNumber();                        // 读取数字
     Token tokenString();                        // 读取字符串
     void processLetter(char inpt);              // 处理字母
     void processNumber(char inpt);              // 处理数字
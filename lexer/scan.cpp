@@ -0,0 +1,84 @@
+#include "scan.h"
+
+#ifdef EWHU_SIMD_LEXER
+#include <immintrin.h>
+
+template <Scan::Class C>
+static size_t wide_sse2(const char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        unsigned stop = ~(unsigned)_mm_movemask_epi8(Scan::sse2_mask<C>(_mm_loadu_si128((const __m128i *)(p + i)))) & 0xFFFF;
+        if (stop)
+            return i + __builtin_ctz(stop);
+    }
+    return i + Scan::scalar_run<C>(p + i, n - i);
+}
+
+static __attribute__((target("avx2"))) inline __m256i in_range(__m256i x, char lo, char hi)
+{
+    __m256i shifted = _mm256_add_epi8(x, _mm256_set1_epi8((char)(0x80 - lo)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + (hi - lo) + 1)), shifted);
+}
+
+// 与 Scan::sse2_mask 相同，一次 32 个字节
+template <Scan::Class C>
+static __attribute__((target("avx2"))) inline __m256i avx2_mask(__m256i x)
+{
+    switch (C)
+    {
+    case Scan::SPACE:
+        return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'))),
+                               _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r')));
+    case Scan::WORD:
+        return _mm256_or_si256(_mm256_or_si256(in_range(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z'), in_range(x, '0', '9')),
+                               _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+    case Scan::DIGIT:
+        return in_range(x, '0', '9');
+    default:
+        return _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))),
+                                                   _mm256_cmpgt_epi8(_mm256_setzero_si256(), x)),
+                                   _mm256_set1_epi8(-1));
+    }
+}
+
+template <Scan::Class C>
+static __attribute__((target("avx2"))) size_t wide_avx2(const char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(avx2_mask<C>(_mm256_loadu_si256((const __m256i *)(p + i))));
+        if (stop)
+            return i + __builtin_ctz(stop);
+    }
+    return i + wide_sse2<C>(p + i, n - i);
+}
+
+// 启动时检测一次 CPU，决定长串用哪种实现
+static bool has_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static const bool use_avx2 = has_avx2();
+
+size_t (*const Scan::wide[4])(const char *p, size_t n) = {
+    use_avx2 ? wide_avx2<SPACE> : wide_sse2<SPACE>,
+    use_avx2 ? wide_avx2<WORD> : wide_sse2<WORD>,
+    use_avx2 ? wide_avx2<DIGIT> : wide_sse2<DIGIT>,
+    use_avx2 ? wide_avx2<STRING> : wide_sse2<STRING>,
+};
+
+const char *Scan::mode()
+{
+    return use_avx2 ? "avx2" : "sse2";
+}
+#else
+const char *Scan::mode()
+{
+    return "scalar";
+}
+#endif
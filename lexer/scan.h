@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))) && \
+    !defined(EWHU_SCALAR_LEXER)
+#define EWHU_SIMD_LEXER
+#include <emmintrin.h>
+#endif
+
+// 按字符类别批量扫描源码
+//
+// x86 上先用 SSE2（x86-64 都支持，可以内联）一次判断 16 个字节；超过 16 个字节的长串
+// 交给启动时按 CPU 选定的实现，支持 AVX2 时一次判断 32 个字节。其他平台逐字节判断。
+class Scan
+{
+public:
+    enum Class
+    {
+        SPACE,  // 空格、制表符、回车（换行要计行号，不在其中）
+        WORD,   // 字母、数字、下划线
+        DIGIT,  // 数字
+        STRING, // 字符串内容：双引号、换行和非 ASCII 字符以外的字符
+    };
+
+    // 从 p 开始连续属于类别 C 的字节数，不超过 n
+    template <Class C>
+    static size_t run(const char *p, size_t n)
+    {
+#ifdef EWHU_SIMD_LEXER
+        if (n >= 16)
+        {
+            unsigned stop = ~(unsigned)_mm_movemask_epi8(sse2_mask<C>(_mm_loadu_si128((const __m128i *)p))) & 0xFFFF;
+            if (stop)
+                return __builtin_ctz(stop);
+            return 16 + wide[C](p + 16, n - 16);
+        }
+#endif
+        return scalar_run<C>(p, n);
+    }
+
+    static const char *mode(); // 启动时选定的实现
+
+    template <Class C>
+    static bool contains(char c)
+    {
+        switch (C)
+        {
+        case SPACE:
+            return c == ' ' || c == '\t' || c == '\r';
+        case WORD:
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        case DIGIT:
+            return c >= '0' && c <= '9';
+        default:
+            return c != '"' && c != '\n' && !(c & 0x80);
+        }
+    }
+
+    template <Class C>
+    static size_t scalar_run(const char *p, size_t n)
+    {
+        size_t i = 0;
+        while (i < n && contains<C>(p[i]))
+            i++;
+        return i;
+    }
+
+#ifdef EWHU_SIMD_LEXER
+    // 属于类别 C 的字节置为 0xFF
+    template <Class C>
+    static __m128i sse2_mask(__m128i x)
+    {
+        switch (C)
+        {
+        case SPACE:
+            return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+                                _mm_cmpeq_epi8(x, _mm_set1_epi8('\r')));
+        case WORD:
+            return _mm_or_si128(_mm_or_si128(in_range(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z'), in_range(x, '0', '9')),
+                                _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+        case DIGIT:
+            return in_range(x, '0', '9');
+        default:
+            // 最高位为 1 的字节（非 ASCII）用 x 自身的符号位排除
+            return _mm_andnot_si128(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'))),
+                                                 _mm_cmplt_epi8(x, _mm_setzero_si128())),
+                                    _mm_set1_epi8(-1));
+        }
+    }
+
+    // lo <= x <= hi：平移到有符号数的最小值处，一次有符号比较即可
+    static __m128i in_range(__m128i x, char lo, char hi)
+    {
+        __m128i shifted = _mm_add_epi8(x, _mm_set1_epi8((char)(0x80 - lo)));
+        return _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(0x80 + (hi - lo) + 1)));
+    }
+
+private:
+    static size_t (*const wide[4])(const char *p, size_t n); // 长串的扫描，下标为类别
+#endif
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 #include <unordered_map>
@@ -86,6 +87,7 @@ enum TokenType
     // Empty
     EMPTY // empty
 };
+constexpr int TOKEN_TYPES = TokenType::EMPTY + 1; // TokenType 的个数
 
 static std::unordered_map<TokenType, std::string> TokenTypeToString = {
     // Single-character tokens.
@@ -170,13 +172,14 @@ class Token
     friend class Tokens;
 
 public:
-    TokenType type;                                               // 标记的类型
-    std::variant<std::monostate, long long, std::string> literal; // 字面量的值
-    int line;                                                     // 标记所在的行号
+    TokenType type;                                                    // 标记的类型
+    std::variant<std::monostate, long long, std::string_view> literal; // 字面量的值，字符串指向源码，标识符指向驻留表
+    int line;                                                          // 标记所在的行号
+    int id = 0;                                                        // 标识符的编号
 
     // 构造函数
-    Token(TokenType type, std::variant<std::monostate, long long, std::string> literal, int line)
-        : type(type), literal(literal), line(line) {}
+    Token(TokenType type, std::variant<std::monostate, long long, std::string_view> literal, int line, int id = 0)
+        : type(type), literal(literal), line(line), id(id) {}
 
     Token() : type(TokenType::ERR), literal(std::monostate()), line(0) {}
 
@@ -194,9 +197,9 @@ public:
         {
             literalStr = std::to_string(std::get<long long>(literal));
         }
-        else if (std::holds_alternative<std::string>(literal))
+        else if (std::holds_alternative<std::string_view>(literal))
         {
-            literalStr = std::get<std::string>(literal);
+            literalStr = std::get<std::string_view>(literal);
         }
 
         // 将 Token 的信息拼接成字符串
@@ -212,11 +215,11 @@ public:
         return 0;
     }
 
-    std::string literalToString()
+    std::string_view literalToString()
     {
-        if (std::holds_alternative<std::string>(literal))
+        if (std::holds_alternative<std::string_view>(literal))
         {
-            return std::get<std::string>(literal);
+            return std::get<std::string_view>(literal);
         }
         return "";
     }
@@ -0,0 +1,385 @@
+#include "bigint.h"
+#include <algorithm>
+#include <stdexcept>
+
+BigInt::BigInt(long long value)
+{
+    m_negative = value < 0;
+    unsigned long long magnitude = m_negative ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    while (magnitude)
+    {
+        m_digits.push_back((uint32_t)magnitude);
+        magnitude >>= 32;
+    }
+}
+
+bool BigInt::fits_long() const
+{
+    if (m_digits.size() > 2)
+        return false;
+    unsigned long long magnitude = 0;
+    for (size_t i = m_digits.size(); i-- > 0;)
+        magnitude = (magnitude << 32) | m_digits[i];
+    return m_negative ? magnitude <= (1ULL << 63) : magnitude < (1ULL << 63);
+}
+
+long long BigInt::to_long() const
+{
+    unsigned long long magnitude = 0;
+    for (size_t i = m_digits.size(); i-- > 0;)
+        magnitude = (magnitude << 32) | m_digits[i];
+    return m_negative ? (long long)(0ULL - magnitude) : (long long)magnitude;
+}
+
+std::string BigInt::str() const
+{
+    if (is_zero())
+        return "0";
+    // 每次除以 10^9，得到低 9 位十进制数
+    Digits digits = m_digits;
+    std::vector<uint32_t> chunks;
+    while (!digits.empty())
+        chunks.push_back(divmod_small(digits, 1000000000));
+    std::string result = m_negative ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;)
+    {
+        std::string chunk = std::to_string(chunks[i]);
+        result.append(9 - chunk.size(), '0');
+        result += chunk;
+    }
+    return result;
+}
+
+int BigInt::compare(const BigInt &left, const BigInt &right)
+{
+    if (left.m_negative != right.m_negative)
+        return left.m_negative ? -1 : 1;
+    int result = compare_digits(left.m_digits, right.m_digits);
+    return left.m_negative ? -result : result;
+}
+
+BigInt BigInt::negate(const BigInt &value)
+{
+    BigInt result = value;
+    result.m_negative = !value.m_negative && !value.is_zero();
+    return result;
+}
+
+BigInt BigInt::add(const BigInt &left, const BigInt &right)
+{
+    BigInt result;
+    if (left.m_negative == right.m_negative)
+    {
+        result.m_digits = add_digits(left.m_digits, right.m_digits);
+        result.m_negative = left.m_negative;
+        return result;
+    }
+    // 异号：绝对值大的减去小的，取大的符号
+    int order = compare_digits(left.m_digits, right.m_digits);
+    if (order == 0)
+        return result;
+    if (order > 0)
+    {
+        result.m_digits = sub_digits(left.m_digits, right.m_digits);
+        result.m_negative = left.m_negative;
+    }
+    else
+    {
+        result.m_digits = sub_digits(right.m_digits, left.m_digits);
+        result.m_negative = right.m_negative;
+    }
+    return result;
+}
+
+BigInt BigInt::sub(const BigInt &left, const BigInt &right)
+{
+    return add(left, negate(right));
+}
+
+BigInt BigInt::mul(const BigInt &left, const BigInt &right)
+{
+    BigInt result;
+    result.m_digits = mul_digits(left.m_digits, right.m_digits);
+    result.m_negative = !result.is_zero() && left.m_negative != right.m_negative;
+    return result;
+}
+
+void BigInt::divmod(const BigInt &left, const BigInt &right, BigInt &quotient, BigInt &remainder)
+{
+    if (right.is_zero())
+        throw std::runtime_error("ZeroDivisionError: integer division by zero");
+    Digits q, r;
+    divmod_digits(left.m_digits, right.m_digits, q, r);
+    quotient.m_digits = std::move(q);
+    quotient.m_negative = !quotient.is_zero() && left.m_negative != right.m_negative;
+    remainder.m_digits = std::move(r);
+    remainder.m_negative = !remainder.is_zero() && left.m_negative;
+}
+
+BigInt BigInt::div(const BigInt &left, const BigInt &right)
+{
+    BigInt quotient, remainder;
+    divmod(left, right, quotient, remainder);
+    return quotient;
+}
+
+BigInt BigInt::mod(const BigInt &left, const BigInt &right)
+{
+    BigInt quotient, remainder;
+    divmod(left, right, quotient, remainder);
+    return remainder;
+}
+
+BigInt BigInt::pow(const BigInt &base, unsigned long long exponent)
+{
+    BigInt result(1);
+    BigInt square = base;
+    while (exponent)
+    {
+        if (exponent & 1)
+            result = mul(result, square);
+        exponent >>= 1;
+        if (exponent)
+            square = mul(square, square);
+    }
+    return result;
+}
+
+BigInt BigInt::gcd(BigInt left, BigInt right)
+{
+    left.m_negative = right.m_negative = false;
+    while (!right.is_zero())
+    {
+        BigInt remainder = mod(left, right);
+        left = std::move(right);
+        right = std::move(remainder);
+    }
+    return left;
+}
+
+void BigInt::trim(Digits &digits)
+{
+    while (!digits.empty() && digits.back() == 0)
+        digits.pop_back();
+}
+
+int BigInt::compare_digits(const Digits &left, const Digits &right)
+{
+    if (left.size() != right.size())
+        return left.size() < right.size() ? -1 : 1;
+    for (size_t i = left.size(); i-- > 0;)
+    {
+        if (left[i] != right[i])
+            return left[i] < right[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BigInt::Digits BigInt::add_digits(const Digits &left, const Digits &right)
+{
+    const Digits &longer = left.size() >= right.size() ? left : right;
+    const Digits &shorter = left.size() >= right.size() ? right : left;
+    Digits result(longer.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); i++)
+    {
+        carry += (uint64_t)longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        result[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    result[longer.size()] = (uint32_t)carry;
+    trim(result);
+    return result;
+}
+
+BigInt::Digits BigInt::sub_digits(const Digits &left, const Digits &right)
+{
+    Digits result(left.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < left.size(); i++)
+    {
+        int64_t diff = (int64_t)left[i] - (i < right.size() ? right[i] : 0) - borrow;
+        borrow = diff < 0;
+        result[i] = (uint32_t)(diff + (borrow << 32));
+    }
+    trim(result);
+    return result;
+}
+
+void BigInt::add_shifted(Digits &target, const Digits &value, size_t shift)
+{
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < value.size(); i++)
+    {
+        carry += (uint64_t)target[shift + i] + value[i];
+        target[shift + i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    for (i += shift; carry && i < target.size(); i++)
+    {
+        carry += target[i];
+        target[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+BigInt::Digits BigInt::mul_schoolbook(const Digits &left, const Digits &right)
+{
+    Digits result(left.size() + right.size());
+    for (size_t i = 0; i < left.size(); i++)
+    {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < right.size(); j++)
+        {
+            carry += result[i + j] + (uint64_t)left[i] * right[j];
+            result[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        result[i + right.size()] = (uint32_t)carry;
+    }
+    trim(result);
+    return result;
+}
+
+BigInt::Digits BigInt::mul_digits(const Digits &left, const Digits &right)
+{
+    if (left.empty() || right.empty())
+        return {};
+    if (left.size() < right.size())
+        return mul_digits(right, left);
+    if (right.size() < KARATSUBA_THRESHOLD)
+        return mul_schoolbook(left, right);
+
+    Digits result(left.size() + right.size());
+    if (left.size() >= 2 * right.size())
+    {
+        // 长短悬殊时把长的乘数按短的长度分段相乘
+        for (size_t i = 0; i < left.size(); i += right.size())
+        {
+            Digits part(left.begin() + i, left.begin() + std::min(i + right.size(), left.size()));
+            trim(part);
+            add_shifted(result, mul_digits(part, right), i);
+        }
+        trim(result);
+        return result;
+    }
+
+    // Karatsuba：x = x1 * B^h + x0，y = y1 * B^h + y0，
+    // x * y = z2 * B^2h + (z1 - z2 - z0) * B^h + z0，其中 z1 = (x0 + x1) * (y0 + y1)，只需三次乘法
+    size_t half = left.size() / 2;
+    auto low = [half](const Digits &digits)
+    {
+        Digits part(digits.begin(), digits.begin() + std::min(half, digits.size()));
+        trim(part);
+        return part;
+    };
+    auto high = [half](const Digits &digits)
+    {
+        return digits.size() > half ? Digits(digits.begin() + half, digits.end()) : Digits();
+    };
+    Digits x0 = low(left), x1 = high(left), y0 = low(right), y1 = high(right);
+    Digits z0 = mul_digits(x0, y0);
+    Digits z2 = mul_digits(x1, y1);
+    Digits z1 = mul_digits(add_digits(x0, x1), add_digits(y0, y1));
+    z1 = sub_digits(sub_digits(z1, z0), z2);
+    add_shifted(result, z0, 0);
+    add_shifted(result, z1, half);
+    add_shifted(result, z2, 2 * half);
+    trim(result);
+    return result;
+}
+
+uint32_t BigInt::divmod_small(Digits &digits, uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (size_t i = digits.size(); i-- > 0;)
+    {
+        uint64_t current = (remainder << 32) | digits[i];
+        digits[i] = (uint32_t)(current / divisor);
+        remainder = current % divisor;
+    }
+    trim(digits);
+    return (uint32_t)remainder;
+}
+
+// Knuth 算法 D：先把除数左移到最高位为 1，再逐位估商并修正
+void BigInt::divmod_digits(const Digits &left, const Digits &right, Digits &quotient, Digits &remainder)
+{
+    if (compare_digits(left, right) < 0)
+    {
+        quotient.clear();
+        remainder = left;
+        return;
+    }
+    if (right.size() == 1)
+    {
+        quotient = left;
+        uint32_t r = divmod_small(quotient, right[0]);
+        remainder.clear();
+        if (r)
+            remainder.push_back(r);
+        return;
+    }
+
+    size_t n = right.size(), m = left.size() - n;
+    int shift = __builtin_clz(right.back());
+    Digits v(n), u(left.size() + 1);
+    for (size_t i = n; i-- > 0;)
+        v[i] = (uint32_t)(((uint64_t)right[i] << shift) | (i ? (uint64_t)right[i - 1] >> (32 - shift) : 0));
+    u[left.size()] = (uint32_t)((uint64_t)left.back() >> (32 - shift));
+    for (size_t i = left.size(); i-- > 0;)
+        u[i] = (uint32_t)(((uint64_t)left[i] << shift) | (i ? (uint64_t)left[i - 1] >> (32 - shift) : 0));
+
+    const uint64_t base = 1ULL << 32;
+    quotient.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;)
+    {
+        uint64_t numerator = ((uint64_t)u[j + n] << 32) | u[j + n - 1];
+        uint64_t qhat = numerator / v[n - 1];
+        uint64_t rhat = numerator % v[n - 1];
+        while (qhat >= base || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2]))
+        {
+            qhat--;
+            rhat += v[n - 1];
+            if (rhat >= base)
+                break;
+        }
+
+        // u[j..j+n] -= qhat * v
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t product = qhat * v[i] + carry;
+            carry = product >> 32;
+            int64_t diff = (int64_t)u[i + j] - (int64_t)(uint32_t)product - borrow;
+            borrow = diff < 0;
+            u[i + j] = (uint32_t)(diff + (borrow << 32));
+        }
+        int64_t diff = (int64_t)u[j + n] - (int64_t)carry - borrow;
+        u[j + n] = (uint32_t)diff;
+
+        // 估大了一，加回一次除数
+        if (diff < 0)
+        {
+            qhat--;
+            uint64_t sum = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                sum += (uint64_t)u[i + j] + v[i];
+                u[i + j] = (uint32_t)sum;
+                sum >>= 32;
+            }
+            u[j + n] += (uint32_t)sum;
+        }
+        quotient[j] = (uint32_t)qhat;
+    }
+    trim(quotient);
+
+    remainder.assign(n, 0);
+    for (size_t i = 0; i < n; i++)
+        remainder[i] = (uint32_t)(((uint64_t)u[i] >> shift) | ((uint64_t)u[i + 1] << (32 - shift)));
+    trim(remainder);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 任意精度整数
+//
+// 符号加绝对值，绝对值按 2^32 进制从低位到高位存放，最高位不为 0（零没有数位，也没有负号）。
+// 除法向零取整、取模的符号与被除数相同，与 long long 的 / 和 % 一致。
+class BigInt
+{
+public:
+    BigInt() {}
+    BigInt(long long value);
+
+    bool is_zero() const { return m_digits.empty(); }
+    bool negative() const { return m_negative; }
+    bool fits_long() const;    // 是否在 long long 范围内
+    long long to_long() const; // fits_long() 时有效
+    size_t size() const { return m_digits.size(); }
+    std::string str() const;
+
+    static int compare(const BigInt &left, const BigInt &right); // 返回 -1、0、1
+    static BigInt negate(const BigInt &value);
+    static BigInt add(const BigInt &left, const BigInt &right);
+    static BigInt sub(const BigInt &left, const BigInt &right);
+    static BigInt mul(const BigInt &left, const BigInt &right);
+    static void divmod(const BigInt &left, const BigInt &right, BigInt &quotient, BigInt &remainder);
+    static BigInt div(const BigInt &left, const BigInt &right);
+    static BigInt mod(const BigInt &left, const BigInt &right);
+    static BigInt pow(const BigInt &base, unsigned long long exponent);
+    static BigInt gcd(BigInt left, BigInt right); // 非负的最大公约数
+
+    // long long 的乘方，结果溢出时返回 false
+    static bool small_pow(long long base, long long exponent, long long &result)
+    {
+        long long power = 1;
+        while (exponent > 0)
+        {
+            if ((exponent & 1) && __builtin_mul_overflow(power, base, &power))
+                return false;
+            exponent >>= 1;
+            if (exponent && __builtin_mul_overflow(base, base, &base))
+                return false;
+        }
+        result = power;
+        return true;
+    }
+
+    static constexpr size_t KARATSUBA_THRESHOLD = 32; // 两个乘数都至少有这么多位时用 Karatsuba 乘法
+
+private:
+    using Digits = std::vector<uint32_t>;
+
+    static void trim(Digits &digits);
+    static int compare_digits(const Digits &left, const Digits &right);
+    static Digits add_digits(const Digits &left, const Digits &right);
+    static Digits sub_digits(const Digits &left, const Digits &right); // 要求 left >= right
+    static void add_shifted(Digits &target, const Digits &value, size_t shift);
+    static Digits mul_schoolbook(const Digits &left, const Digits &right);
+    static Digits mul_digits(const Digits &left, const Digits &right);
+    static uint32_t divmod_small(Digits &digits, uint32_t divisor); // 原地除以一位数，返回余数
+    static void divmod_digits(const Digits &left, const Digits &right, Digits &quotient, Digits &remainder);
+
+private:
+    bool m_negative = false;
+    Digits m_digits;
+};
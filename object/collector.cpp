@@ -0,0 +1,117 @@
+#include "collector.h"
+#include "object.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+void Collector::track(Ob_Array *array)
+{
+    // 在登记新数组之前回收：新数组还没有被 Ref 持有，不能参与计数
+    if (m_enabled && !m_collecting && m_count >= m_next)
+        collect();
+    array->m_gc_prev = nullptr;
+    array->m_gc_next = m_head;
+    if (m_head)
+        m_head->m_gc_prev = array;
+    m_head = array;
+    m_count++;
+}
+
+void Collector::untrack(Ob_Array *array)
+{
+    if (array->m_gc_prev)
+        array->m_gc_prev->m_gc_next = array->m_gc_next;
+    else
+        m_head = array->m_gc_next;
+    if (array->m_gc_next)
+        array->m_gc_next->m_gc_prev = array->m_gc_prev;
+    m_count--;
+}
+
+// 元素是数组时返回它
+static Ob_Array *array_of(const Value &value)
+{
+    if (value.m_tag != Value::VALUE_OBJECT || value.m_obj->type() != Object::OBJECT_ARRAY)
+        return nullptr;
+    return static_cast<Ob_Array *>(value.m_obj);
+}
+
+long long Collector::collect()
+{
+    if (m_collecting)
+        return 0;
+    m_collecting = true;
+    auto start = std::chrono::steady_clock::now();
+
+    // 1. 引用计数减去来自其他数组的引用；不被 Ref 持有的数组（如栈上的临时对象）视为根
+    for (Ob_Array *array = m_head; array; array = array->m_gc_next)
+    {
+        long long refs = array->ref_count();
+        array->m_gc_refs = refs > 0 ? refs : 1;
+    }
+    for (Ob_Array *array = m_head; array; array = array->m_gc_next)
+    {
+        for (auto &element : array->m_array)
+        {
+            if (auto target = array_of(element))
+                target->m_gc_refs--;
+        }
+    }
+
+    // 2. 从仍有外部引用的数组出发标记
+    std::vector<Ob_Array *> pending;
+    for (Ob_Array *array = m_head; array; array = array->m_gc_next)
+    {
+        if (array->m_gc_refs > 0)
+            pending.push_back(array);
+    }
+    while (!pending.empty())
+    {
+        Ob_Array *array = pending.back();
+        pending.pop_back();
+        if (array->m_gc_refs < 0)
+            continue;
+        array->m_gc_refs = -1;
+        for (auto &element : array->m_array)
+        {
+            auto target = array_of(element);
+            if (target && target->m_gc_refs >= 0)
+                pending.push_back(target);
+        }
+    }
+
+    // 3. 未标记的数组只被环上的数组引用：先全部持有，再清空元素打断环，最后一起释放
+    std::vector<Ref<Ob_Array>> garbage;
+    for (Ob_Array *array = m_head; array; array = array->m_gc_next)
+    {
+        if (array->m_gc_refs >= 0)
+            garbage.emplace_back(array);
+    }
+    for (auto &array : garbage)
+        array->m_array.clear();
+    long long freed = garbage.size();
+    garbage.clear();
+
+    m_next = std::max(m_threshold, m_count * GROWTH);
+    long long pause = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    m_collections++;
+    m_freed += freed;
+    m_pause_ns += pause;
+    m_max_pause_ns = std::max(m_max_pause_ns, pause);
+    m_collecting = false;
+    return freed;
+}
+
+void Collector::enable(long long threshold)
+{
+    m_enabled = true;
+    m_threshold = threshold;
+    m_next = std::max(m_threshold, m_count * GROWTH);
+}
+
+std::string Collector::report()
+{
+    char pause[64];
+    snprintf(pause, sizeof(pause), "%.3fms, max %.3fms", m_pause_ns / 1e6, m_max_pause_ns / 1e6);
+    return std::to_string(m_collections) + " collections, " + std::to_string(m_freed) + " arrays freed, pause " + pause;
+}
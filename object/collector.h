@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+class Ob_Array;
+
+// 数组的循环回收器
+//
+// 对象仍由引用计数管理，回收器只处理引用计数释放不了的环（如把数组追加到自身）。
+// 做法是试探删除：从每个数组的引用计数中减去来自其他数组的引用，剩下的就是来自数组之外的引用
+// （作用域链、各后端的栈、求值器中的临时值等），以这些数组为根标记，标记不到的数组清空元素后随引用计数释放。
+// 所有数组挂在一条侵入式链表上；开启后数组数量超过阈值时自动回收，阈值随存活的数组数增长。
+class Collector
+{
+public:
+    static void track(Ob_Array *array);   // 新建的数组（先按需回收）
+    static void untrack(Ob_Array *array); // 析构的数组
+
+    static long long collect();                    // 回收一次，返回释放的数组数
+    static void enable(long long threshold = 1000); // 开启自动回收，threshold 为触发回收的最少数组数
+    static bool enabled() { return m_enabled; }
+    static std::string report(); // 回收次数、释放数与停顿时间
+
+private:
+    static constexpr long long GROWTH = 2; // 下次回收时的数组数 = 存活数 * GROWTH（不少于阈值）
+
+    inline static Ob_Array *m_head = nullptr; // 所有存活的数组
+    inline static long long m_count = 0;      // 存活的数组数
+    inline static bool m_enabled = false;
+    inline static bool m_collecting = false;
+    inline static long long m_threshold = 1000;
+    inline static long long m_next = 1000; // 数组数达到此值时回收
+
+    inline static long long m_collections = 0;
+    inline static long long m_freed = 0;
+    inline static long long m_pause_ns = 0;     // 累计停顿
+    inline static long long m_max_pause_ns = 0; // 最长停顿
+};
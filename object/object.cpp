@@ -11,8 +11,11 @@ std::unordered_map<Object::Type, std::string> Object::m_names = {
     {Object::OBJECT_IDENTIFIER, "Identifier"},
     {Object::OBJECT_NULL, "Null"},
     {Object::OBJECT_BREAK, "Break"},
+    {Object::OBJECT_CONTINUE, "Continue"},
     {Object::OBJECT_RETURN, "Return"},
     {Object::OBJECT_ARRAY, "Array"},
+    {Object::OBJECT_BIGINT, "BigInt"},
+    {Object::OBJECT_BIGFRACTION, "BigFraction"},
 };
 
 std::string Object::name() const
@@ -24,3 +27,32 @@ std::string Object::name() const
     }
     return "UnknownType";
 }
+
+
+void Object::type_error(Type expected) const
+{
+    throw std::runtime_error("TypeError: expected " + m_names[expected] + ", got " + name());
+}
+
+std::string Value::name() const
+{
+    if (m_tag == VALUE_OBJECT)
+        return m_obj->name();
+    return Object::m_names[type()];
+}
+std::string Object::stats()
+{
+    std::string result = "Objects:\n";
+    for (int type = 0; type <= OBJECT_INDEX; type++)
+    {
+        if (peak[type] == 0)
+            continue;
+        auto it = m_names.find((Type)type);
+        result += (it != m_names.end() ? it->second : "Type" + std::to_string(type)) +
+                  ": live " + std::to_string(live[type]) + ", peak " + std::to_string(peak[type]) + "\n";
+    }
+    result += "Pool: " + std::to_string(Pool::used()) + " bytes in use, " +
+              std::to_string(Pool::reserved()) + " bytes reserved\n";
+    result += "GC: " + Collector::report();
+    return result;
+}
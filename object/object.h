@@ -3,12 +3,17 @@
 #include <cmath>
 #include <numeric>
 #include <string>
-#include <memory>
 #include <stdarg.h>
 #include <stdexcept>
 #include <vector>
+#include "pool.h"
+#include "collector.h"
+#include "rational.h"
 
-class Object
+class Value;
+class Ob_Fraction;
+
+class Object : public RefCounted
 {
 public:
     enum Type
@@ -25,263 +30,262 @@ public:
         OBJECT_CONTINUE,    // continue
         OBJECT_RETURN,      // 函数返回
         OBJECT_ARRAY,       // 数组
+        OBJECT_BIGINT,      // 超出 long long 范围的整数
+        OBJECT_BIGFRACTION, // 分子或分母超出 long long 范围的分数
         OBJECT_INDEX,
     };
 
 public:
-    Object() {}
-    Object(Type type) : m_type(type) {}
-    Object(const Object &obj) : m_type(obj.m_type) {};
-    virtual ~Object() {};
+    Object() : Object(OBJECT_ERROR) {}
+    Object(Type type) : m_type(type) { created(type); }
+    Object(const Object &obj) : Object(obj.m_type) {};
+    virtual ~Object() { live[m_type]--; };
+
+    // 对象从内存池分配；析构函数是虚函数，释放时按实际类型的大小归还
+    static void *operator new(size_t size) { return Pool::allocate(size); }
+    static void operator delete(void *pointer, size_t size) { Pool::deallocate(pointer, size); }
 
-    virtual std::shared_ptr<Object> clone() = 0;
     virtual std::string str() const = 0;
 
     Type type() const { return m_type; }
     std::string name() const;
 
-public:
-    static std::unordered_map<Type, std::string> m_names;
+    static std::string stats(); // 各类型对象的存活数与峰值，以及内存池的用量
 
-    Type m_type;
-    // 字符串
-    std::string m_string;
-    // 变量名
-    std::string m_name;
-    // 指向变量的指针
-    void *m_value;
-    // 变量类型
-    Object::Type m_value_type;
-    // 整数 or 布尔值 or 分数整数部分
-    long long m_int;
-    // 分数分子
-    long long num;
-    // 分数分母
-    long long den;
-    // 列表
-    std::vector<std::shared_ptr<Object>> m_array;
-};
-
-class Ob_Identifier : public Object
-{
-public:
-    Ob_Identifier() : Object(Object::OBJECT_IDENTIFIER) {}
-    Ob_Identifier(std::string name) : Object(Object::OBJECT_IDENTIFIER) { m_name = name; }
-    Ob_Identifier(std::string name, void *value, Object::Type type) : Object(Object::OBJECT_IDENTIFIER)
+private:
+    void created(Type type)
     {
-        m_name = name, m_value = value, m_value_type = type;
+        if (++live[type] > peak[type])
+            peak[type] = live[type];
     }
-    Ob_Identifier(const Ob_Identifier &obj) : Object(Object::OBJECT_IDENTIFIER)
-    {
-        m_name = obj.m_name;
-        m_value = obj.m_value;
-        m_value_type = obj.m_value_type;
-    }
-    ~Ob_Identifier() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Identifier>(*this);
-    }
-    virtual std::string str() const
-    {
-        return m_name;
-    }
+    inline static long long live[OBJECT_INDEX + 1] = {}; // 各类型存活的对象数
+    inline static long long peak[OBJECT_INDEX + 1] = {}; // 各类型存活对象数的峰值
 
 public:
-};
+    static std::unordered_map<Type, std::string> m_names;
+
+    Type m_type;
 
-class Ob_Boolean : public Object
-{
 public:
-    Ob_Boolean() : Object(Object::OBJECT_BOOLEAN) {}
-    Ob_Boolean(long long value) : Object(Object::OBJECT_BOOLEAN) { m_int = value; }
-    Ob_Boolean(const Ob_Boolean &obj) : Object(Object::OBJECT_BOOLEAN) { m_int = obj.m_int; }
-    ~Ob_Boolean() {}
+    // 各类型的数据只存放在对应的子类中，通过以下函数访问（定义在本文件末尾），类型不符时抛出 TypeError
+    std::string &string();       // String
+    std::vector<Value> &array(); // Array
+    const BigInt &bigint();      // BigInt
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Boolean>(*this);
-    }
-    virtual std::string str() const
+private:
+    void expect(Type type) const
     {
-        return (m_int ? "true" : "false");
+        if (m_type != type)
+            type_error(type);
     }
-
-public:
+    [[noreturn]] void type_error(Type expected) const;
 };
 
-class Ob_Integer : public Object
+// 值：整数、布尔值、空值和较小的分数直接存放，字符串、数组、较大的分数等装箱为 Object
+//
+// 整数与对象指针共用 8 字节，由 m_tag 区分；装箱时 Value 持有对象的一个引用。
+// 分子分母都在 32 位以内的分数压进这 8 字节（见 Rational::pack），运算时不分配内存。
+// 字符串和分数创建后不再修改，复制 Value 即可共享同一个对象；运算（包括 ++）总是产生新的对象。
+// 数组按引用共享，修改对所有持有者可见。
+class Value
 {
 public:
-    Ob_Integer() : Object(Object::OBJECT_INTEGER) { m_int = (0); }
-    Ob_Integer(long long value) : Object(Object::OBJECT_INTEGER) { m_int = (value); }
-    Ob_Integer(const Ob_Integer &obj) : Object(Object::OBJECT_INTEGER) { m_int = obj.m_int; }
-    ~Ob_Integer() {}
-
-    virtual std::shared_ptr<Object> clone()
+    enum Tag : unsigned char
     {
-        return std::make_shared<Ob_Integer>(*this);
-    }
-    virtual std::string str() const
-    {
-        return std::to_string(m_int);
-    }
-};
+        VALUE_NULL = 0, // 空值，也表示没有结果
+        VALUE_INTEGER,  // 整数
+        VALUE_BOOLEAN,  // 布尔值
+        VALUE_OBJECT,   // 装箱的对象
+        VALUE_FRACTION, // 压缩存放的分数
+    };
 
-class Ob_Fraction : public Object
-{
 public:
-    Ob_Fraction() : Object(Object::OBJECT_FRACTION)
+    Value() {}
+    Value(std::nullptr_t) {}
+    template <typename T>
+    Value(Ref<T> obj)
     {
-        num = (0);
-        den = (1);
-    }
-    Ob_Fraction(long long numerator, long long denominator) : Object(Object::OBJECT_FRACTION)
-    {
-        num = (numerator);
-        den = (denominator);
-        simplify();
-    }
-    Ob_Fraction(const Ob_Fraction &fraction) : Object(Object::OBJECT_FRACTION)
-    {
-        num = (fraction.num);
-        den = (fraction.den);
-        simplify();
+        if (obj)
+        {
+            m_tag = VALUE_OBJECT;
+            m_obj = obj.detach();
+        }
     }
-    Ob_Fraction(float value) : Object(Object::OBJECT_FRACTION)
+    Value(const Value &other) : m_tag(other.m_tag), m_int(other.m_int)
     {
-        num = (value * 1000000);
-        den = (1000000);
-        simplify();
+        if (m_tag == VALUE_OBJECT)
+            m_obj->retain();
     }
-    ~Ob_Fraction() {}
-
-    virtual std::shared_ptr<Object> clone()
+    Value(Value &&other) noexcept : m_tag(other.m_tag), m_int(other.m_int) { other.m_tag = VALUE_NULL; }
+    ~Value()
     {
-        return std::make_shared<Ob_Fraction>(*this);
+        if (m_tag == VALUE_OBJECT)
+            m_obj->release();
     }
-
-    static Ob_Fraction simplify(const Ob_Fraction &fraction)
+    Value &operator=(const Value &other)
     {
-        long long gcd = std::gcd(fraction.num, fraction.den);
-        return Ob_Fraction(fraction.num / gcd, fraction.den / gcd);
+        if (other.m_tag == VALUE_OBJECT)
+            other.m_obj->retain();
+        if (m_tag == VALUE_OBJECT)
+            m_obj->release();
+        m_tag = other.m_tag;
+        m_int = other.m_int;
+        return *this;
     }
-    void simplify()
+    Value &operator=(Value &&other) noexcept
     {
-        long long gcd = std::gcd(num, den);
-        num /= gcd;
-        den /= gcd;
-        if (den < 0)
+        if (this != &other)
         {
-            num = -num;
-            den = -den;
+            if (m_tag == VALUE_OBJECT)
+                m_obj->release();
+            m_tag = other.m_tag;
+            m_int = other.m_int;
+            other.m_tag = VALUE_NULL;
         }
+        return *this;
     }
 
-    float toFloat() const
+    static Value integer(long long value)
     {
-        return (float)num / den;
+        Value v;
+        v.m_tag = VALUE_INTEGER;
+        v.m_int = value;
+        return v;
     }
-
-    virtual std::string realStr() const
+    static Value boolean(long long value)
     {
-        return std::to_string(num) + "/" + std::to_string(den);
+        Value v;
+        v.m_tag = VALUE_BOOLEAN;
+        v.m_int = value != 0;
+        return v;
+    }
+    static Value small_fraction(const Rational &value) // 要求 value.packable()
+    {
+        Value v;
+        v.m_tag = VALUE_FRACTION;
+        v.m_int = value.pack();
+        return v;
     }
 
-    virtual std::string str() const
+    Object::Type type() const
     {
-        long long integerPart = num / den;
-        if (integerPart == 0)
+        switch (m_tag)
         {
-            return std::to_string(num) + "/" + std::to_string(den);
+        case VALUE_INTEGER:
+            return Object::OBJECT_INTEGER;
+        case VALUE_BOOLEAN:
+            return Object::OBJECT_BOOLEAN;
+        case VALUE_OBJECT:
+            return m_obj->type();
+        case VALUE_FRACTION:
+            return Object::OBJECT_FRACTION;
+        default:
+            return Object::OBJECT_NULL;
         }
-        long long decimalPart = num % den;
-        if (decimalPart == 0)
+    }
+    std::string name() const;
+    std::string str() const
+    {
+        switch (m_tag)
         {
-            return std::to_string(integerPart);
+        case VALUE_INTEGER:
+            return std::to_string(m_int);
+        case VALUE_BOOLEAN:
+            return m_int ? "true" : "false";
+        case VALUE_OBJECT:
+            return m_obj->str();
+        case VALUE_FRACTION:
+            return Rational::unpack(m_int).str();
+        default:
+            return "";
         }
-        return std::to_string(integerPart) + "(" + std::to_string(decimalPart) + "/" + std::to_string(den) + ")";
     }
 
-    static Ob_Fraction add(const std::shared_ptr<Ob_Fraction> &left, const std::shared_ptr<Ob_Fraction> &right)
-    {
-        return Ob_Fraction(left->num * right->den + right->num * left->den,
-                           left->den * right->den);
-    }
-    static Ob_Fraction sub(const std::shared_ptr<Ob_Fraction> &left, const std::shared_ptr<Ob_Fraction> &right)
-    {
-        return Ob_Fraction(left->num * right->den - right->num * left->den,
-                           left->den * right->den);
-    }
-    static Ob_Fraction mul(const std::shared_ptr<Ob_Fraction> &left, const std::shared_ptr<Ob_Fraction> &right)
-    {
-        return Ob_Fraction(left->num * right->num, left->den * right->den);
-    }
-    static Ob_Fraction div(const std::shared_ptr<Ob_Fraction> &left, const std::shared_ptr<Ob_Fraction> &right)
-    {
-        return Ob_Fraction(left->num * right->den, left->den * right->num);
-    }
-    static Ob_Fraction pow(const std::shared_ptr<Ob_Fraction> &left, const std::shared_ptr<Ob_Fraction> &right)
-    {
-        return Ob_Fraction(std::pow(left->toFloat(), right->toFloat()));
-    }
-    static Ob_Fraction mod(const std::shared_ptr<Ob_Fraction> &left, const std::shared_ptr<Ob_Fraction> &right)
+    bool is_number() const { return m_tag == VALUE_INTEGER || m_tag == VALUE_BOOLEAN; }
+    explicit operator bool() const { return m_tag != VALUE_NULL; }
+    Object *operator->() const { return m_obj; } // 访问装箱的对象
+
+    bool operator==(const Value &other) const
     {
-        long long numerator = (left->num * right->den) % (left->den * right->num);
-        long long denominator = left->den * right->den;
-        return Ob_Fraction(numerator, denominator);
+        if (m_tag != other.m_tag)
+            return false;
+        if (m_tag == VALUE_OBJECT)
+            return m_obj == other.m_obj;
+        return m_int == other.m_int;
     }
-    Ob_Boolean equal(const std::shared_ptr<Ob_Fraction> &right) const
+    bool operator!=(const Value &other) const { return !(*this == other); }
+
+public:
+    Tag m_tag = VALUE_NULL;
+    union
     {
-        return Ob_Boolean(num * right->den == right->num * den);
-    }
-    Ob_Boolean notEqual(const std::shared_ptr<Ob_Fraction> &right) const
+        long long m_int = 0; // 整数或布尔值
+        Object *m_obj;       // 装箱的对象
+    };
+};
+
+class Ob_Identifier : public Object
+{
+public:
+    Ob_Identifier() : Object(Object::OBJECT_IDENTIFIER) {}
+    Ob_Identifier(std::string name) : Object(Object::OBJECT_IDENTIFIER) { m_name = name; }
+    Ob_Identifier(std::string name, void *value, Object::Type type) : Object(Object::OBJECT_IDENTIFIER)
     {
-        return Ob_Boolean(num * right->den != right->num * den);
+        m_name = name, m_value = value, m_value_type = type;
     }
-    Ob_Boolean lessThan(const std::shared_ptr<Ob_Fraction> &right) const
+    Ob_Identifier(const Ob_Identifier &obj) : Object(Object::OBJECT_IDENTIFIER)
     {
-        return Ob_Boolean(num * right->den < right->num * den);
+        m_name = obj.m_name;
+        m_value = obj.m_value;
+        m_value_type = obj.m_value_type;
     }
-    Ob_Boolean greaterThan(const std::shared_ptr<Ob_Fraction> &right) const
+    ~Ob_Identifier() {}
+
+    virtual std::string str() const
     {
-        return Ob_Boolean(num * right->den > right->num * den);
+        return m_name;
     }
-    Ob_Boolean lessEqual(const std::shared_ptr<Ob_Fraction> &right) const
+
+public:
+    std::string m_name;         // 变量名
+    void *m_value;              // 指向变量的指针
+    Object::Type m_value_type; // 变量类型
+};
+
+// 分子分母在 long long 范围内、但不能压缩存放的分数
+class Ob_Fraction : public Object
+{
+public:
+    Ob_Fraction(const Rational &value) : Object(Object::OBJECT_FRACTION), m_value(value) {}
+    ~Ob_Fraction() {}
+
+    virtual std::string str() const
     {
-        return Ob_Boolean(num * right->den <= right->num * den);
+        return m_value.str();
     }
-    Ob_Boolean greaterEqual(const std::shared_ptr<Ob_Fraction> &right) const
+
+    // 运算结果：能压缩时直接存放，否则装箱
+    static Value make(const Rational &value)
     {
-        return Ob_Boolean(num * right->den >= right->num * den);
+        if (value.packable())
+            return Value::small_fraction(value);
+        return make_object<Ob_Fraction>(value);
     }
+    static Value make(long long num, long long den); // 两个整数之比，den 不能为 0
 
-    static Ob_Fraction decimalToFraction(long long integerPart, long long decimalPart)
+    // 分数或整数的值
+    static Rational of(const Value &value)
     {
-
-        // 计算小数部分的位数
-        int decimalDigits = 0;
-        int temp = decimalPart;
-        while (temp > 0)
-        {
-            temp /= 10;
-            decimalDigits++;
-        }
-
-        // 分子和分母的计算
-        long long denominator = std::pow(10, decimalDigits);
-        long long numerator = integerPart * denominator + decimalPart;
-
-        // 约分
-        long long gcd = std::gcd(numerator, denominator);
-        numerator /= gcd;
-        denominator /= gcd;
-
-        return Ob_Fraction(numerator, denominator);
+        if (value.m_tag == Value::VALUE_FRACTION)
+            return Rational::unpack(value.m_int);
+        if (value.is_number())
+            return Rational{value.m_int, 1};
+        return static_cast<const Ob_Fraction *>(value.m_obj)->m_value;
     }
 
 public:
+    const Rational m_value;
 };
 /*
 class Ob_Trignometry : public Object
@@ -343,17 +347,13 @@ public:
     Ob_String(const Ob_String &obj) : Object(Object::OBJECT_STRING) { m_string = obj.m_string; }
     ~Ob_String() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_String>(*this);
-    }
-
     virtual std::string str() const
     {
         return "'" + m_string + "'";
     }
 
 public:
+    std::string m_string;
 };
 
 class Ob_Break : public Object
@@ -362,10 +362,6 @@ public:
     Ob_Break() : Object(Object::OBJECT_BREAK) {}
     ~Ob_Break() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Break>(*this);
-    }
     virtual std::string str() const
     {
         return "";
@@ -378,10 +374,6 @@ public:
     Ob_Continue() : Object(Object::OBJECT_CONTINUE) {}
     ~Ob_Continue() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Continue>(*this);
-    }
     virtual std::string str() const
     {
         return "";
@@ -391,20 +383,16 @@ public:
 class Ob_Return : public Object
 {
 public:
-    Ob_Return(std::shared_ptr<Object> obj) : Object(Object::OBJECT_RETURN) { m_expression = obj; }
+    Ob_Return(Value value) : Object(Object::OBJECT_RETURN) { m_expression = value; }
     ~Ob_Return() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Return>(*this);
-    }
     virtual std::string str() const
     {
         return "";
     }
 
 public:
-    std::shared_ptr<Object> m_expression;
+    Value m_expression;
 };
 
 class Ob_Null : public Object
@@ -413,32 +401,27 @@ public:
     Ob_Null() : Object(Object::OBJECT_NULL) {}
     ~Ob_Null() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Null>(*this);
-    }
     virtual std::string str() const
     {
         return "";
     }
 };
 
-class Ob_Array : public Object, public std::enable_shared_from_this<Ob_Array>
+class Ob_Array : public Object
 {
 public:
-    Ob_Array() : Object(Object::OBJECT_ARRAY) {}
-    Ob_Array(const Ob_Array &obj) : Object(Object::OBJECT_ARRAY) { m_array = obj.m_array; }
-    ~Ob_Array() {}
-
-    virtual std::shared_ptr<Object> clone() override
+    Ob_Array() : Object(Object::OBJECT_ARRAY) { Collector::track(this); }
+    Ob_Array(const Ob_Array &obj) : Object(Object::OBJECT_ARRAY)
     {
-        return std::dynamic_pointer_cast<Object>(shared_from_this());
+        Collector::track(this);
+        m_array = obj.m_array;
     }
+    ~Ob_Array() { Collector::untrack(this); }
 
-    std::shared_ptr<Object> add(const std::shared_ptr<Object> &obj)
+    Ref<Object> add(Object *obj)
     {
-        m_array.insert(m_array.end(), obj->m_array.begin(), obj->m_array.end());
-        return std::make_shared<Ob_Array>(*this);
+        m_array.insert(m_array.end(), obj->array().begin(), obj->array().end());
+        return make_object<Ob_Array>(*this);
     }
     virtual std::string str() const
     {
@@ -446,9 +429,9 @@ public:
         {
             std::string r;
             r += '[';
-            for (auto &i : Object::m_array)
+            for (auto &i : m_array)
             {
-                r += i->str();
+                r += i.str();
                 r += ',';
             }
             r.pop_back();
@@ -462,6 +445,78 @@ public:
     }
 
 public:
+    std::vector<Value> m_array;
+
+    // 回收器使用
+    Ob_Array *m_gc_prev = nullptr;
+    Ob_Array *m_gc_next = nullptr;
+    long long m_gc_refs = 0; // 回收时：来自数组之外的引用数，-1 表示已标记
+};
+
+// 超出 long long 范围的整数，范围内的整数总是直接存放在 Value 中
+class Ob_BigInt : public Object
+{
+public:
+    Ob_BigInt(BigInt value) : Object(Object::OBJECT_BIGINT), m_value(std::move(value)) {}
+    ~Ob_BigInt() {}
+
+    virtual std::string str() const
+    {
+        return m_value.str();
+    }
+
+    // 运算结果：在 long long 范围内时直接存放，否则装箱
+    static Value make(BigInt value)
+    {
+        if (value.fits_long())
+            return Value::integer(value.to_long());
+        return make_object<Ob_BigInt>(std::move(value));
+    }
+
+    // 整数或大整数的值
+    static BigInt of(const Value &value);
+
+public:
+    const BigInt m_value;
+};
+
+// 分子或分母超出 long long 范围的分数
+class Ob_BigFraction : public Object
+{
+public:
+    Ob_BigFraction(BigRational value) : Object(Object::OBJECT_BIGFRACTION), m_value(std::move(value)) {}
+    ~Ob_BigFraction() {}
+
+    virtual std::string str() const
+    {
+        return m_value.str();
+    }
+
+    // 运算结果：分子分母都在 long long 范围内时转为 Ob_Fraction::make
+    static Value make(BigRational value)
+    {
+        Rational small;
+        if (value.narrow(small))
+            return Ob_Fraction::make(small);
+        return make_object<Ob_BigFraction>(std::move(value));
+    }
+
+    // 任意分数、整数或大整数的值
+    static BigRational of(const Value &value)
+    {
+        switch (value.type())
+        {
+        case Object::OBJECT_FRACTION:
+            return Ob_Fraction::of(value);
+        case Object::OBJECT_BIGFRACTION:
+            return static_cast<const Ob_BigFraction *>(value.m_obj)->m_value;
+        default:
+            return BigRational(Ob_BigInt::of(value), 1);
+        }
+    }
+
+public:
+    const BigRational m_value;
 };
 
 class Ob_Index : public Object
@@ -470,16 +525,36 @@ public:
     Ob_Index() : Object(Object::OBJECT_INDEX) {}
     ~Ob_Index() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Index>(*this);
-    }
     virtual std::string str() const
     {
         return "";
     }
 
 public:
-    std::shared_ptr<Object> m_array;
-    std::shared_ptr<Ob_Integer> m_index;
+    Ref<Object> m_array;
+    Value m_index;
 };
+
+inline std::string &Object::string()
+{
+    expect(OBJECT_STRING);
+    return static_cast<Ob_String *>(this)->m_string;
+}
+inline std::vector<Value> &Object::array()
+{
+    expect(OBJECT_ARRAY);
+    return static_cast<Ob_Array *>(this)->m_array;
+}
+inline Value Ob_Fraction::make(long long num, long long den)
+{
+    Rational value;
+    if (Rational::reduce(num, den, value))
+        return make(value);
+    return Ob_BigFraction::make(BigRational::reduce(num, den));
+}
+inline const BigInt &Object::bigint()
+{
+    expect(OBJECT_BIGINT);
+    return static_cast<Ob_BigInt *>(this)->m_value;
+}
+inline BigInt Ob_BigInt::of(const Value &value) { return value.is_number() ? BigInt(value.m_int) : value->bigint(); }
@@ -9,10 +9,6 @@ public:
     Ob_Funtion(std::shared_ptr<Node> node) : Object(Object::OBJECT_INDEX), m_node(node) {}
     ~Ob_Funtion() {}
 
-    virtual std::shared_ptr<Object> clone()
-    {
-        return std::make_shared<Ob_Funtion>(*this);
-    }
     virtual std::string str() const
     {
         return "";
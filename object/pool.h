@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "ref.h"
+
+// 运行时对象的内存池：按 16 字节分级，每级一条空闲链表
+//
+// 解释器是单线程的，池不加锁。向系统申请的块从不归还（全局作用域等静态对象析构时还会释放对象），
+// 所有状态都是零初始化的静态变量，不受静态对象构造顺序的影响。
+class Pool
+{
+public:
+    static constexpr size_t GRANULE = 16;
+    static constexpr size_t MAX_SIZE = 256;         // 更大的请求直接交给 operator new
+    static constexpr size_t BLOCK_SIZE = 64 * 1024; // 每次向系统申请的字节数
+
+    static void *allocate(size_t size)
+    {
+        allocation_count++;
+        if (size > MAX_SIZE)
+            return ::operator new(size);
+        size_t index = (size + GRANULE - 1) / GRANULE - 1;
+        if (!free_lists[index])
+            refill(index);
+        Free *slot = free_lists[index];
+        free_lists[index] = slot->next;
+        used_bytes += (index + 1) * GRANULE;
+        return slot;
+    }
+
+    static void deallocate(void *pointer, size_t size) noexcept
+    {
+        if (size > MAX_SIZE)
+        {
+            ::operator delete(pointer);
+            return;
+        }
+        size_t index = (size + GRANULE - 1) / GRANULE - 1;
+        Free *slot = static_cast<Free *>(pointer);
+        slot->next = free_lists[index];
+        free_lists[index] = slot;
+        used_bytes -= (index + 1) * GRANULE;
+    }
+
+    static size_t used() { return used_bytes; }         // 池中正在使用的字节数
+    static size_t reserved() { return reserved_bytes; } // 向系统申请的字节数
+    static long long allocations() { return allocation_count; } // 累计分配的次数
+
+private:
+    struct Free
+    {
+        Free *next;
+    };
+
+    // 申请新块并切成该级大小的槽位；块头记录上一块，所有块始终可达
+    static void refill(size_t index)
+    {
+        size_t slot_size = (index + 1) * GRANULE;
+        char *block = static_cast<char *>(::operator new(BLOCK_SIZE));
+        *reinterpret_cast<char **>(block) = blocks;
+        blocks = block;
+        reserved_bytes += BLOCK_SIZE;
+        for (size_t offset = GRANULE; offset + slot_size <= BLOCK_SIZE; offset += slot_size)
+        {
+            Free *slot = reinterpret_cast<Free *>(block + offset);
+            slot->next = free_lists[index];
+            free_lists[index] = slot;
+        }
+    }
+
+private:
+    inline static Free *free_lists[MAX_SIZE / GRANULE] = {};
+    inline static char *blocks = nullptr;
+    inline static size_t used_bytes = 0;
+    inline static size_t reserved_bytes = 0;
+    inline static long long allocation_count = 0;
+};
+
+// 创建运行时对象，代替 std::make_shared（Object 的 operator new 从池中分配）
+template <typename T, typename... Args>
+Ref<T> make_object(Args &&...args)
+{
+    return Ref<T>(new T(std::forward<Args>(args)...));
+}
@@ -0,0 +1,283 @@
+#pragma once
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include "bigint.h"
+
+// 分数运算的核心：分母为正的既约分数，分子分母都在 long long 范围内
+//
+// 运算先交叉约分，再用 128 位整数计算中间结果，不会溢出；结果超出 long long 时返回 false，
+// 由调用方改用 BigRational 重新计算。
+struct Rational
+{
+    long long num = 0; // 分子
+    long long den = 1; // 分母
+
+    // 二进制 GCD（Stein 算法），只用移位和减法
+    static unsigned long long gcd(unsigned long long a, unsigned long long b)
+    {
+        if (a == 0 || b == 0)
+            return a | b;
+        int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        do
+        {
+            b >>= __builtin_ctzll(b);
+            if (a > b)
+                std::swap(a, b);
+            b -= a;
+        } while (b);
+        return a << shift;
+    }
+    static unsigned __int128 gcd(unsigned __int128 a, unsigned __int128 b)
+    {
+        if ((a >> 64) == 0 && (b >> 64) == 0)
+            return gcd((unsigned long long)a, (unsigned long long)b);
+        if (a == 0 || b == 0)
+            return a | b;
+        int shift = ctz(a | b);
+        a >>= ctz(a);
+        do
+        {
+            b >>= ctz(b);
+            if (a > b)
+                std::swap(a, b);
+            b -= a;
+        } while (b);
+        return a << shift;
+    }
+
+    // 约分并把符号移到分子上，den 不能为 0；结果超出 long long 时返回 false
+    static bool reduce(__int128 num, __int128 den, Rational &out)
+    {
+        if (den < 0)
+        {
+            num = -num;
+            den = -den;
+        }
+        if (num == (long long)num && den == (long long)den)
+        {
+            // 多数情况下都在 64 位以内，避免 128 位除法
+            long long g = gcd(magnitude((long long)num), (unsigned long long)den);
+            out.num = (long long)num / g;
+            out.den = (long long)den / g;
+            return true;
+        }
+        unsigned __int128 g = gcd((unsigned __int128)(num < 0 ? -num : num), (unsigned __int128)den);
+        return fit(num / (__int128)g, den / (__int128)g, out);
+    }
+
+    static bool add(const Rational &l, const Rational &r, Rational &out)
+    {
+        if (l.den == r.den)
+            return reduce((__int128)l.num + r.num, l.den, out);
+        // 分母先除以公因数，中间结果的绝对值小于 2^127
+        long long g = gcd((unsigned long long)l.den, (unsigned long long)r.den);
+        __int128 num = (__int128)l.num * (r.den / g) + (__int128)r.num * (l.den / g);
+        return reduce(num, (__int128)l.den * (r.den / g), out);
+    }
+    static bool sub(const Rational &l, const Rational &r, Rational &out)
+    {
+        if (l.den == r.den)
+            return reduce((__int128)l.num - r.num, l.den, out);
+        long long g = gcd((unsigned long long)l.den, (unsigned long long)r.den);
+        __int128 num = (__int128)l.num * (r.den / g) - (__int128)r.num * (l.den / g);
+        return reduce(num, (__int128)l.den * (r.den / g), out);
+    }
+    static bool mul(const Rational &l, const Rational &r, Rational &out)
+    {
+        // 交叉约分后的乘积已经是既约的
+        unsigned long long g1 = gcd(magnitude(l.num), r.den);
+        unsigned long long g2 = gcd(magnitude(r.num), l.den);
+        return fit((__int128)quotient(l.num, g1) * quotient(r.num, g2),
+                   (__int128)quotient(l.den, g2) * quotient(r.den, g1), out);
+    }
+    static bool div(const Rational &l, const Rational &r, Rational &out) // r 不能为 0
+    {
+        unsigned long long g1 = gcd(magnitude(l.num), magnitude(r.num));
+        unsigned long long g2 = gcd((unsigned long long)l.den, (unsigned long long)r.den);
+        __int128 num = (__int128)quotient(l.num, g1) * quotient(r.den, g2);
+        __int128 den = (__int128)quotient(l.den, g2) * quotient(r.num, g1);
+        if (den < 0)
+        {
+            num = -num;
+            den = -den;
+        }
+        return fit(num, den, out);
+    }
+    static bool mod(const Rational &l, const Rational &r, Rational &out) // r 不能为 0
+    {
+        // a/b % c/d = (a*d % b*c) / (b*d)，余数的符号与被除数相同
+        __int128 num = ((__int128)l.num * r.den) % ((__int128)l.den * r.num);
+        return reduce(num, (__int128)l.den * r.den, out);
+    }
+    static int compare(const Rational &l, const Rational &r)
+    {
+        __int128 a = (__int128)l.num * r.den, b = (__int128)r.num * l.den;
+        return a < b ? -1 : a > b;
+    }
+
+    // 整数次幂，平方求幂，结果是精确的；l 为 0 时 exponent 不能为负
+    static bool pow(const Rational &l, long long exponent, Rational &out)
+    {
+        Rational base = l;
+        if (exponent < 0 && !reduce(l.den, l.num, base))
+            return false;
+        Rational result{1, 1};
+        for (unsigned long long n = magnitude(exponent); n; n >>= 1)
+        {
+            if ((n & 1) && !mul(result, base, result))
+                return false;
+            if (n > 1 && !mul(base, base, base))
+                return false;
+        }
+        out = result;
+        return true;
+    }
+    // 非整数次幂按浮点数计算，保留六位小数；结果不是有限值或超出范围时返回 false
+    static bool from_float(double value, Rational &out)
+    {
+        value = std::round(value * 1000000);
+        if (!(value > -9e18 && value < 9e18))
+            return false;
+        return reduce((long long)value, 1000000, out);
+    }
+    double to_float() const { return (double)num / den; }
+
+    // 小数字面量：整数部分和小数部分的数字
+    static Rational decimal(long long integerPart, long long decimalPart)
+    {
+        // 计算小数部分的位数
+        int decimalDigits = 0;
+        int temp = decimalPart;
+        while (temp > 0)
+        {
+            temp /= 10;
+            decimalDigits++;
+        }
+        long long denominator = std::pow(10, decimalDigits);
+        Rational result;
+        reduce((__int128)integerPart * denominator + decimalPart, denominator, result);
+        return result;
+    }
+
+    std::string str() const
+    {
+        long long integerPart = num / den;
+        if (integerPart == 0)
+            return std::to_string(num) + "/" + std::to_string(den);
+        long long decimalPart = num % den;
+        if (decimalPart == 0)
+            return std::to_string(integerPart);
+        return std::to_string(integerPart) + "(" + std::to_string(decimalPart) + "/" + std::to_string(den) + ")";
+    }
+
+    // 分子分母都在 32 位以内时可以压进 8 字节，直接存放在 Value 中
+    bool packable() const { return num >= INT32_MIN && num <= INT32_MAX && den <= UINT32_MAX; }
+    long long pack() const { return (long long)(((unsigned long long)(uint32_t)num << 32) | (uint32_t)den); }
+    static Rational unpack(long long bits)
+    {
+        return Rational{(int32_t)(uint32_t)((unsigned long long)bits >> 32), (long long)(uint32_t)bits};
+    }
+
+private:
+    static bool fit(__int128 num, __int128 den, Rational &out)
+    {
+        if (num < LLONG_MIN || num > LLONG_MAX || den > LLONG_MAX)
+            return false;
+        out.num = (long long)num;
+        out.den = (long long)den;
+        return true;
+    }
+    static unsigned long long magnitude(long long value)
+    {
+        return value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    }
+    // value / g，g 整除 value；g 只有在 value 为 LLONG_MIN 或 0 时才可能是 2^63
+    static long long quotient(long long value, unsigned long long g)
+    {
+        if (g > LLONG_MAX)
+            return value == 0 ? 0 : -1;
+        return value / (long long)g;
+    }
+    static int ctz(unsigned __int128 value)
+    {
+        auto low = (unsigned long long)value;
+        return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll((unsigned long long)(value >> 64));
+    }
+};
+
+// 分子分母为任意精度整数的分数，Rational 溢出时使用
+struct BigRational
+{
+    BigInt num;
+    BigInt den = 1;
+
+    BigRational() {}
+    BigRational(const Rational &value) : num(value.num), den(value.den) {}
+    BigRational(BigInt numerator, BigInt denominator) : num(std::move(numerator)), den(std::move(denominator)) {}
+
+    // 约分并把符号移到分子上，den 不能为 0
+    static BigRational reduce(BigInt num, BigInt den)
+    {
+        if (den.negative())
+        {
+            num = BigInt::negate(num);
+            den = BigInt::negate(den);
+        }
+        BigInt g = BigInt::gcd(num, den);
+        return BigRational(BigInt::div(num, g), BigInt::div(den, g));
+    }
+
+    static BigRational add(const BigRational &l, const BigRational &r)
+    {
+        return reduce(BigInt::add(BigInt::mul(l.num, r.den), BigInt::mul(r.num, l.den)), BigInt::mul(l.den, r.den));
+    }
+    static BigRational sub(const BigRational &l, const BigRational &r)
+    {
+        return reduce(BigInt::sub(BigInt::mul(l.num, r.den), BigInt::mul(r.num, l.den)), BigInt::mul(l.den, r.den));
+    }
+    static BigRational mul(const BigRational &l, const BigRational &r)
+    {
+        return reduce(BigInt::mul(l.num, r.num), BigInt::mul(l.den, r.den));
+    }
+    static BigRational div(const BigRational &l, const BigRational &r) // r 不能为 0
+    {
+        return reduce(BigInt::mul(l.num, r.den), BigInt::mul(l.den, r.num));
+    }
+    static BigRational mod(const BigRational &l, const BigRational &r) // r 不能为 0
+    {
+        return reduce(BigInt::mod(BigInt::mul(l.num, r.den), BigInt::mul(l.den, r.num)), BigInt::mul(l.den, r.den));
+    }
+    static BigRational pow(const BigRational &l, unsigned long long exponent)
+    {
+        return BigRational(BigInt::pow(l.num, exponent), BigInt::pow(l.den, exponent));
+    }
+    static int compare(const BigRational &l, const BigRational &r)
+    {
+        return BigInt::compare(BigInt::mul(l.num, r.den), BigInt::mul(r.num, l.den));
+    }
+
+    // 分子分母都在 long long 范围内时转为 Rational
+    bool narrow(Rational &out) const
+    {
+        if (!num.fits_long() || !den.fits_long())
+            return false;
+        out.num = num.to_long();
+        out.den = den.to_long();
+        return true;
+    }
+
+    std::string str() const
+    {
+        BigInt integerPart, decimalPart;
+        BigInt::divmod(num, den, integerPart, decimalPart);
+        if (integerPart.is_zero())
+            return num.str() + "/" + den.str();
+        if (decimalPart.is_zero())
+            return integerPart.str();
+        return integerPart.str() + "(" + decimalPart.str() + "/" + den.str() + ")";
+    }
+};
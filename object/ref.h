@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#ifdef EWHU_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
+
+// 侵入式引用计数的基类
+//
+// 解释器是单线程的，计数默认不用原子操作；需要在多线程中共享对象时用 EWHU_ATOMIC_REFCOUNT 编译。
+// 计数放在对象内，对象与计数一起分配，也不需要 shared_ptr 的控制块。
+// 加减计数的累计次数只在用 EWHU_REFCOUNT_STATS 编译时统计，供 -b 报告。
+class RefCounted
+{
+public:
+#ifdef EWHU_ATOMIC_REFCOUNT
+    using Count = std::atomic<uint32_t>;
+    using Stat = std::atomic<long long>;
+#else
+    using Count = uint32_t;
+    using Stat = long long;
+#endif
+
+    RefCounted() {}
+    RefCounted(const RefCounted &) {} // 复制对象时不复制计数
+    RefCounted &operator=(const RefCounted &) { return *this; }
+    virtual ~RefCounted() {}
+
+    void retain() const
+    {
+        ++m_refs;
+#ifdef EWHU_REFCOUNT_STATS
+        ++retains;
+#endif
+    }
+    void release() const
+    {
+#ifdef EWHU_REFCOUNT_STATS
+        ++releases;
+#endif
+        if (--m_refs == 0)
+            delete this;
+    }
+    uint32_t ref_count() const { return m_refs; } // 没有被 Ref 持有（如栈上的临时对象）时为 0
+
+#ifdef EWHU_REFCOUNT_STATS
+    inline static Stat retains = 0;  // 累计的加计数次数
+    inline static Stat releases = 0; // 累计的减计数次数
+#endif
+
+private:
+    mutable Count m_refs = 0;
+};
+
+// 持有 RefCounted 对象的指针，用法与 std::shared_ptr 相同
+template <typename T>
+class Ref
+{
+public:
+    Ref() {}
+    Ref(std::nullptr_t) {}
+    explicit Ref(T *ptr) : m_ptr(ptr)
+    {
+        if (m_ptr)
+            m_ptr->retain();
+    }
+    Ref(const Ref &other) : Ref(other.m_ptr) {}
+    Ref(Ref &&other) noexcept : m_ptr(other.detach()) {}
+    template <typename U>
+    Ref(const Ref<U> &other) : Ref(other.get()) {}
+    template <typename U>
+    Ref(Ref<U> &&other) noexcept : m_ptr(other.detach()) {}
+    ~Ref()
+    {
+        if (m_ptr)
+            m_ptr->release();
+    }
+
+    Ref &operator=(Ref other) noexcept
+    {
+        std::swap(m_ptr, other.m_ptr);
+        return *this;
+    }
+
+    // 交出所有权，不改变计数
+    T *detach() noexcept
+    {
+        T *ptr = m_ptr;
+        m_ptr = nullptr;
+        return ptr;
+    }
+
+    T *get() const { return m_ptr; }
+    T *operator->() const { return m_ptr; }
+    T &operator*() const { return *m_ptr; }
+    explicit operator bool() const { return m_ptr != nullptr; }
+
+    template <typename U>
+    bool operator==(const Ref<U> &other) const { return m_ptr == other.get(); }
+    template <typename U>
+    bool operator!=(const Ref<U> &other) const { return m_ptr != other.get(); }
+
+private:
+    T *m_ptr = nullptr;
+};
+
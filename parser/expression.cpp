@@ -1,6 +1,6 @@
 #include "parser.h"
 
-std::shared_ptr<Expression> Parser::parse_group()
+NodeRef<Expression> Parser::parse_group()
 {
     next_token();
     auto ele = parse_expression(LOWEST);
@@ -8,32 +8,31 @@ std::shared_ptr<Expression> Parser::parse_group()
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_expression(int precedence)
+NodeRef<Expression> Parser::parse_expression(int precedence)
 {
-    auto prefix = m_prefix_parse_fns.find(m_curr.type);
-    if (prefix == m_prefix_parse_fns.end())
+    auto prefix = m_rules.prefix[m_curr.type];
+    if (!prefix)
     {
         no_prefix_parse_fn_error(m_curr.type);
         return nullptr;
     }
-    std::shared_ptr<Expression> ele = (this->*(prefix->second))();
+    NodeRef<Expression> ele = (this->*prefix)();
     while (!peek_token_is(TokenType::SEMICOLON) && !peek_token_is(TokenType::COMMA) && precedence < peek_token_precedence())
     {
-        auto infix = m_infix_parse_fns.find(m_peek.type);
-        if (infix == m_infix_parse_fns.end())
+        auto infix = m_rules.infix[m_peek.type];
+        if (!infix)
         {
             return ele;
         }
         next_token();
-        ele = (this->*(infix->second))(ele);
+        ele = (this->*infix)(ele);
     }
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_prefix()
+NodeRef<Expression> Parser::parse_prefix()
 {
-    std::shared_ptr<Prefix> ele(new Prefix());
-    ele->m_token = m_curr;
+    auto ele = make_node<Prefix>();
     ele->m_operator = m_curr.type;
     // int precedence = curr_token_precedence();
     next_token();
@@ -41,20 +40,18 @@ std::shared_ptr<Expression> Parser::parse_prefix()
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_trignometry()
+NodeRef<Expression> Parser::parse_trignometry()
 {
-    std::shared_ptr<Prefix> ele(new Prefix());
-    ele->m_token = m_curr;
+    auto ele = make_node<Prefix>();
     ele->m_operator = m_curr.type;
     next_token();
     ele->m_right = parse_expression(LOWEST);
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_index(const std::shared_ptr<Expression> &left)
+NodeRef<Expression> Parser::parse_index(const NodeRef<Expression> &left)
 {
-    std::shared_ptr<Infix> ele(new Infix());
-    ele->m_token = m_curr;
+    auto ele = make_node<Infix>();
     ele->m_operator = m_curr.type;
     ele->m_left = left;
     next_token();
@@ -64,10 +61,9 @@ std::shared_ptr<Expression> Parser::parse_index(const std::shared_ptr<Expression
     next_token();
     return ele;
 }
-std::shared_ptr<Expression> Parser::parse_infix(const std::shared_ptr<Expression> &left)
+NodeRef<Expression> Parser::parse_infix(const NodeRef<Expression> &left)
 {
-    std::shared_ptr<Infix> ele(new Infix());
-    ele->m_token = m_curr;
+    auto ele = make_node<Infix>();
     ele->m_operator = m_curr.type;
     ele->m_left = left;
     int precedence = curr_token_precedence();
@@ -76,9 +72,9 @@ std::shared_ptr<Expression> Parser::parse_infix(const std::shared_ptr<Expression
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_array()
+NodeRef<Expression> Parser::parse_array()
 {
-    std::shared_ptr<Array> ary(new Array());
+    auto ary = make_node<Array>();
     if (m_curr.type == TokenType::LEFT_BRACKET)
     {
         while (m_peek.type != TokenType::RIGHT_BRACKET)
@@ -1,26 +1,20 @@
 #include "parser.h"
 
-std::shared_ptr<Expression> Parser::parse_identifier()
+NodeRef<Expression> Parser::parse_identifier()
 {
     if (m_peek.type == TokenType::LEFT_PAREN)
     {
         return parse_identifier_function();
     }
-    auto ele = std::make_shared<Identifier>();
-    ele->m_token = this->m_curr;
-    auto string_name = m_curr.literalToString();
-    ele->m_name = hash(string_name); // 转换
-    identifier_map.insert({ele->m_name, string_name});
+    auto ele = make_node<Identifier>();
+    ele->m_name = m_curr.id; // 词法分析时已驻留
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_identifier_function()
+NodeRef<Expression> Parser::parse_identifier_function()
 {
-    auto ele = std::make_shared<FunctionIdentifier>();
-    ele->m_token = this->m_curr;
-    auto string_name = m_curr.literalToString();
-    ele->m_name = hash(string_name); // 转换
-    function_map.insert({ele->m_name, string_name});
+    auto ele = make_node<FunctionIdentifier>();
+    ele->m_name = m_curr.id; // 词法分析时已驻留
     next_token();
     if (m_curr.type == TokenType::LEFT_PAREN)
     {
@@ -28,7 +22,7 @@ std::shared_ptr<Expression> Parser::parse_identifier_function()
         {
             next_token();
             auto arg = parse_expression(Precedence::LOWEST);
-            ele->m_initial_list.push_back(std::dynamic_pointer_cast<Expression>(arg));
+            ele->m_initial_list.push_back(dynamic_node_cast<Expression>(arg));
             if (m_peek.type == TokenType::COMMA)
                 next_token();
         }
@@ -37,26 +31,23 @@ std::shared_ptr<Expression> Parser::parse_identifier_function()
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_integer()
+NodeRef<Expression> Parser::parse_integer()
 {
-    auto ele = std::make_shared<Integer>();
-    ele->m_token = this->m_curr;
+    auto ele = make_node<Integer>();
     ele->m_value = m_curr.literalToLonglong(); // 转换
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_boolean()
+NodeRef<Expression> Parser::parse_boolean()
 {
-    auto ele = std::make_shared<Boolean>();
-    ele->m_token = this->m_curr;
+    auto ele = make_node<Boolean>();
     ele->m_bool = (m_curr.type == TokenType::TRUE) ? true : false;
     return ele;
 }
 
-std::shared_ptr<Expression> Parser::parse_string()
+NodeRef<Expression> Parser::parse_string()
 {
-    std::shared_ptr<String> ele(new String());
-    ele->m_token = this->m_curr;
-    ele->m_string = m_curr.literalToString(); // 转换
+    auto ele = make_node<String>();
+    ele->m_string = std::string(m_curr.literalToString()); // 转换
     return ele;
 }
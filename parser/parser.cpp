@@ -1,118 +1,101 @@
 #include "parser.h"
 
-std::map<TokenType, int> Parser::m_precedences =
-    {
-        {TokenType::EQUAL, ASSIGN},
-
-        {TokenType::AND, LOGICAL},
-        {TokenType::OR, LOGICAL},
-        {TokenType::XOR, LOGICAL},
-
-        {TokenType::SHL, BIT},
-        {TokenType::SHR, BIT},
-        {TokenType::BIT_XOR, BIT},
-        {TokenType::BIT_AND, BIT},
-        {TokenType::BIT_OR, BIT},
-
-        {TokenType::EQUAL_EQUAL, EQUALS},
-        {TokenType::BANG_EQUAL, EQUALS},
-        {TokenType::LESS, EQUALS},
-        {TokenType::GREATER, EQUALS},
-        {TokenType::LESS_EQUAL, EQUALS},
-        {TokenType::GREATER_EQUAL, EQUALS},
-
-        {TokenType::MINUS, SUM},
-        {TokenType::PLUS, SUM},
-
-        {TokenType::STAR, PRODUCT},
-        {TokenType::SLASH, PRODUCT},
-        {TokenType::PERCENT, PRODUCT},
-        {TokenType::SLASH_SLASH, PRODUCT},
-
-        {TokenType::STAR_STAR, POWER},
-
-        {TokenType::SIN, TRIGNOMETRY},
-        {TokenType::COS, TRIGNOMETRY},
-        {TokenType::TAN, TRIGNOMETRY},
-
-        {TokenType::DOT, DOT},
-        {TokenType::LEFT_BRACKET, INDEX},
-};
-std::unordered_map<TokenType, Parser::prefix_parse_fn> Parser::m_prefix_parse_fns =
-    {
-        {TokenType::TRUE, &Parser::parse_boolean},
-        {TokenType::FALSE, &Parser::parse_boolean},
-        {TokenType::INTEGER, &Parser::parse_integer},
-        {TokenType::STRING, &Parser::parse_string},
-        {TokenType::LEFT_PAREN, &Parser::parse_group},
-        {TokenType::PLUS, &Parser::parse_prefix},
-        {TokenType::PLUS_PLUS, &Parser::parse_prefix},
-        {TokenType::MINUS, &Parser::parse_prefix},
-        {TokenType::BANG, &Parser::parse_prefix},
-        {TokenType::IDENTIFIER, &Parser::parse_identifier},
-        {TokenType::LEFT_BRACKET, &Parser::parse_array},
-        {TokenType::SIN, &Parser::parse_trignometry},
-        {TokenType::COS, &Parser::parse_trignometry},
-        {TokenType::TAN, &Parser::parse_trignometry}
-
-};
-std::unordered_map<TokenType, Parser::infix_parse_fn> Parser::m_infix_parse_fns =
-    {
-        {TokenType::PLUS, &Parser::parse_infix},
-        {TokenType::MINUS, &Parser::parse_infix},
-        {TokenType::STAR, &Parser::parse_infix},
-        {TokenType::STAR_STAR, &Parser::parse_infix},
-        {TokenType::SLASH, &Parser::parse_infix},
-        {TokenType::SLASH_SLASH, &Parser::parse_infix},
-        {TokenType::PERCENT, &Parser::parse_infix},
-
-        {TokenType::EQUAL_EQUAL, &Parser::parse_infix},
-        {TokenType::BANG_EQUAL, &Parser::parse_infix},
-        {TokenType::LESS, &Parser::parse_infix},
-        {TokenType::GREATER, &Parser::parse_infix},
-        {TokenType::LESS_EQUAL, &Parser::parse_infix},
-        {TokenType::GREATER_EQUAL, &Parser::parse_infix},
-
-        {TokenType::DOT, &Parser::parse_infix},
-
-        {TokenType::EQUAL, &Parser::parse_infix},
-        {TokenType::SHR, &Parser::parse_infix},
-        {TokenType::SHL, &Parser::parse_infix},
-        {TokenType::BIT_XOR, &Parser::parse_infix},
-        {TokenType::BIT_OR, &Parser::parse_infix},
-        {TokenType::BIT_AND, &Parser::parse_infix},
-        {TokenType::LEFT_BRACKET, &Parser::parse_index},
-        {TokenType::AND, &Parser::parse_infix},
-        {TokenType::OR, &Parser::parse_infix},
-        {TokenType::XOR, &Parser::parse_infix}
-
-};
-std::unordered_map<TokenType, Parser::control_flow_fn> Parser::m_control_flow_fns =
-    {
-        {TokenType::LEFT_BRACE, &Parser::parse_statement_block},
-        {TokenType::IF, &Parser::parse_if_statement},
-        {TokenType::WHILE, &Parser::parse_while_statement},
-        {TokenType::BREAK, &Parser::parse_break_statement},
-        {TokenType::CONTINUE, &Parser::parse_continue_statement},
-        {TokenType::FUNC, &Parser::parse_function_declaration},
-        {TokenType::RETURN, &Parser::parse_return_statement},
-};
-
-std::unordered_map<TokenType, Parser::suffix_parse_fn> Parser::m_suffix_parse_fns =
-    {
-
-};
-
-int Parser::hash(const std::string &str)
+constexpr Parser::Rules Parser::make_rules()
 {
-    int hash = 0;
-    for (char c : str)
-    {
-        hash = hash * 31 + c;
-    }
-    return hash;
+    Rules rules;
+
+    rules.precedence[TokenType::EQUAL] = ASSIGN;
+
+    rules.precedence[TokenType::AND] = LOGICAL;
+    rules.precedence[TokenType::OR] = LOGICAL;
+    rules.precedence[TokenType::XOR] = LOGICAL;
+
+    rules.precedence[TokenType::SHL] = BIT;
+    rules.precedence[TokenType::SHR] = BIT;
+    rules.precedence[TokenType::BIT_XOR] = BIT;
+    rules.precedence[TokenType::BIT_AND] = BIT;
+    rules.precedence[TokenType::BIT_OR] = BIT;
+
+    rules.precedence[TokenType::EQUAL_EQUAL] = EQUALS;
+    rules.precedence[TokenType::BANG_EQUAL] = EQUALS;
+    rules.precedence[TokenType::LESS] = EQUALS;
+    rules.precedence[TokenType::GREATER] = EQUALS;
+    rules.precedence[TokenType::LESS_EQUAL] = EQUALS;
+    rules.precedence[TokenType::GREATER_EQUAL] = EQUALS;
+
+    rules.precedence[TokenType::MINUS] = SUM;
+    rules.precedence[TokenType::PLUS] = SUM;
+
+    rules.precedence[TokenType::STAR] = PRODUCT;
+    rules.precedence[TokenType::SLASH] = PRODUCT;
+    rules.precedence[TokenType::PERCENT] = PRODUCT;
+    rules.precedence[TokenType::SLASH_SLASH] = PRODUCT;
+
+    rules.precedence[TokenType::STAR_STAR] = POWER;
+
+    rules.precedence[TokenType::SIN] = TRIGNOMETRY;
+    rules.precedence[TokenType::COS] = TRIGNOMETRY;
+    rules.precedence[TokenType::TAN] = TRIGNOMETRY;
+
+    rules.precedence[TokenType::DOT] = DOT;
+    rules.precedence[TokenType::LEFT_BRACKET] = INDEX;
+
+    rules.prefix[TokenType::TRUE] = &Parser::parse_boolean;
+    rules.prefix[TokenType::FALSE] = &Parser::parse_boolean;
+    rules.prefix[TokenType::INTEGER] = &Parser::parse_integer;
+    rules.prefix[TokenType::STRING] = &Parser::parse_string;
+    rules.prefix[TokenType::LEFT_PAREN] = &Parser::parse_group;
+    rules.prefix[TokenType::PLUS] = &Parser::parse_prefix;
+    rules.prefix[TokenType::PLUS_PLUS] = &Parser::parse_prefix;
+    rules.prefix[TokenType::MINUS] = &Parser::parse_prefix;
+    rules.prefix[TokenType::BANG] = &Parser::parse_prefix;
+    rules.prefix[TokenType::IDENTIFIER] = &Parser::parse_identifier;
+    rules.prefix[TokenType::LEFT_BRACKET] = &Parser::parse_array;
+    rules.prefix[TokenType::SIN] = &Parser::parse_trignometry;
+    rules.prefix[TokenType::COS] = &Parser::parse_trignometry;
+    rules.prefix[TokenType::TAN] = &Parser::parse_trignometry;
+
+    rules.infix[TokenType::PLUS] = &Parser::parse_infix;
+    rules.infix[TokenType::MINUS] = &Parser::parse_infix;
+    rules.infix[TokenType::STAR] = &Parser::parse_infix;
+    rules.infix[TokenType::STAR_STAR] = &Parser::parse_infix;
+    rules.infix[TokenType::SLASH] = &Parser::parse_infix;
+    rules.infix[TokenType::SLASH_SLASH] = &Parser::parse_infix;
+    rules.infix[TokenType::PERCENT] = &Parser::parse_infix;
+
+    rules.infix[TokenType::EQUAL_EQUAL] = &Parser::parse_infix;
+    rules.infix[TokenType::BANG_EQUAL] = &Parser::parse_infix;
+    rules.infix[TokenType::LESS] = &Parser::parse_infix;
+    rules.infix[TokenType::GREATER] = &Parser::parse_infix;
+    rules.infix[TokenType::LESS_EQUAL] = &Parser::parse_infix;
+    rules.infix[TokenType::GREATER_EQUAL] = &Parser::parse_infix;
+
+    rules.infix[TokenType::DOT] = &Parser::parse_infix;
+
+    rules.infix[TokenType::EQUAL] = &Parser::parse_infix;
+    rules.infix[TokenType::SHR] = &Parser::parse_infix;
+    rules.infix[TokenType::SHL] = &Parser::parse_infix;
+    rules.infix[TokenType::BIT_XOR] = &Parser::parse_infix;
+    rules.infix[TokenType::BIT_OR] = &Parser::parse_infix;
+    rules.infix[TokenType::BIT_AND] = &Parser::parse_infix;
+    rules.infix[TokenType::LEFT_BRACKET] = &Parser::parse_index;
+    rules.infix[TokenType::AND] = &Parser::parse_infix;
+    rules.infix[TokenType::OR] = &Parser::parse_infix;
+    rules.infix[TokenType::XOR] = &Parser::parse_infix;
+
+    rules.control_flow[TokenType::LEFT_BRACE] = &Parser::parse_statement_block;
+    rules.control_flow[TokenType::IF] = &Parser::parse_if_statement;
+    rules.control_flow[TokenType::WHILE] = &Parser::parse_while_statement;
+    rules.control_flow[TokenType::BREAK] = &Parser::parse_break_statement;
+    rules.control_flow[TokenType::CONTINUE] = &Parser::parse_continue_statement;
+    rules.control_flow[TokenType::FUNC] = &Parser::parse_function_declaration;
+    rules.control_flow[TokenType::RETURN] = &Parser::parse_return_statement;
+
+    return rules;
 }
 
+constexpr Parser::Rules Parser::m_rules = Parser::make_rules();
+
 void Parser::next_token() // 读取下一个token
 {
     m_curr = m_peek;
@@ -167,20 +150,12 @@ void Parser::peek_error(TokenType type)
 
 int Parser::curr_token_precedence()
 {
-    auto it = m_precedences.find(m_curr.type);
-    if (it != m_precedences.end())
-        return it->second;
-    else
-        return LOWEST;
+    return m_rules.precedence[m_curr.type];
 }
 
 int Parser::peek_token_precedence()
 {
-    auto it = m_precedences.find(m_peek.type);
-    if (it != m_precedences.end())
-        return it->second;
-    else
-        return LOWEST;
+    return m_rules.precedence[m_peek.type];
 }
 
 void Parser::no_prefix_parse_fn_error(TokenType type)
@@ -1,5 +1,4 @@
 #pragma once
-#include <map>
 #include <list>
 #include <memory>
 #include <unordered_map>
@@ -32,32 +31,32 @@ public:
     Parser();
     Parser(std::vector<Token>::iterator ptokens); // 构造函数，接受token列表的一个迭代器
     ~Parser();
-    static int hash(const std::string &str);
-    static constexpr int prehash(const char *str);
 
     void parse_program(std::vector<Token> &tokens); // 解析程序
+    void parse_program(std::vector<Token>::iterator begin, std::vector<Token>::iterator end); // 解析一段 Token
 
 public:
     std::shared_ptr<Program> m_program = nullptr;
-    std::unordered_map<int, std::string> identifier_map; // 标识符反映射
-    std::unordered_map<int, std::string> function_map;   // 函数反映射
 
 private:
     // 前缀表达式函数原型定义
-    typedef std::shared_ptr<Expression> (Parser::*prefix_parse_fn)(void);
+    typedef NodeRef<Expression> (Parser::*prefix_parse_fn)(void);
     // 中缀表达式函数原型定义
-    typedef std::shared_ptr<Expression> (Parser::*infix_parse_fn)(const std::shared_ptr<Expression> &left);
+    typedef NodeRef<Expression> (Parser::*infix_parse_fn)(const NodeRef<Expression> &left);
     // 后缀表达式函数原型定义
-    typedef std::shared_ptr<Expression> (Parser::*suffix_parse_fn)(const std::shared_ptr<Expression> &left);
+    typedef NodeRef<Expression> (Parser::*suffix_parse_fn)(const NodeRef<Expression> &left);
     // 控制流语句函数原型定义
-    typedef std::shared_ptr<Statement> (Parser::*control_flow_fn)(void);
+    typedef NodeRef<Statement> (Parser::*control_flow_fn)(void);
+
+    template <typename T>
+    NodeRef<T> make_node() { return m_program->m_arena->make<T>(); } // 在程序的分配区中创建节点
 
     void new_sentence(std::vector<Token>::iterator ptokens, std::vector<Token>::iterator ptokens_end);
-    std::shared_ptr<Statement> parse_statement();
+    NodeRef<Statement> parse_statement();
 
     // 函数
-    std::shared_ptr<Statement> parse_function_declaration();
-    std::shared_ptr<ExpressionStatement> parse_expression_statement();
+    NodeRef<Statement> parse_function_declaration();
+    NodeRef<ExpressionStatement> parse_expression_statement();
 
     void next_token();                    // 读取下一个token
     bool curr_token_is(TokenType ty);     // 判断当前token是否是ty类型
@@ -70,33 +69,33 @@ private:
 
     void no_prefix_parse_fn_error(TokenType ty);
 
-    std::list<std::string> &errors();                             // 返回m_errors
-    std::shared_ptr<Expression> parse_expression(int precedence); // 处理表达式
+    std::list<std::string> &errors();                     // 返回m_errors
+    NodeRef<Expression> parse_expression(int precedence); // 处理表达式
 
     // 前缀
-    std::shared_ptr<Expression> parse_integer();
-    std::shared_ptr<Expression> parse_string();
-    std::shared_ptr<Expression> parse_boolean();
-    std::shared_ptr<Expression> parse_group();
-    std::shared_ptr<Expression> parse_prefix();
-    std::shared_ptr<Expression> parse_identifier();
-    std::shared_ptr<Expression> parse_identifier_function();
-    std::shared_ptr<Expression> parse_array();
-    std::shared_ptr<Expression> parse_trignometry();
+    NodeRef<Expression> parse_integer();
+    NodeRef<Expression> parse_string();
+    NodeRef<Expression> parse_boolean();
+    NodeRef<Expression> parse_group();
+    NodeRef<Expression> parse_prefix();
+    NodeRef<Expression> parse_identifier();
+    NodeRef<Expression> parse_identifier_function();
+    NodeRef<Expression> parse_array();
+    NodeRef<Expression> parse_trignometry();
     // 中缀
-    std::shared_ptr<Expression> parse_infix(const std::shared_ptr<Expression> &left);
-    std::shared_ptr<Expression> parse_index(const std::shared_ptr<Expression> &left);
+    NodeRef<Expression> parse_infix(const NodeRef<Expression> &left);
+    NodeRef<Expression> parse_index(const NodeRef<Expression> &left);
 
     // 后缀
-    // std::shared_ptr<Expression> parse_suffix(const std::shared_ptr<Expression> &left){};
+    // NodeRef<Expression> parse_suffix(const NodeRef<Expression> &left){};
 
     // 控制流
-    std::shared_ptr<Statement> parse_statement_block(); // 语句块
-    std::shared_ptr<Statement> parse_if_statement();    // if语句
-    std::shared_ptr<Statement> parse_while_statement(); // while语句
-    std::shared_ptr<Statement> parse_break_statement();
-    std::shared_ptr<Statement> parse_continue_statement();
-    std::shared_ptr<Statement> parse_return_statement();
+    NodeRef<Statement> parse_statement_block(); // 语句块
+    NodeRef<Statement> parse_if_statement();    // if语句
+    NodeRef<Statement> parse_while_statement(); // while语句
+    NodeRef<Statement> parse_break_statement();
+    NodeRef<Statement> parse_continue_statement();
+    NodeRef<Statement> parse_return_statement();
 
 private:
     std::vector<Token>::iterator m_ptokens;     // 指向下一个token的迭代器
@@ -106,19 +105,14 @@ private:
     Token m_peek;                    // 下一个token
     std::list<std::string> m_errors; // 存储错误的列表
 
-    static std::map<TokenType, int> m_precedences; // 一个从运算符TokenType类型到优先级类型的映射
-    static std::unordered_map<TokenType, prefix_parse_fn> m_prefix_parse_fns;
-    static std::unordered_map<TokenType, infix_parse_fn> m_infix_parse_fns;
-    static std::unordered_map<TokenType, suffix_parse_fn> m_suffix_parse_fns;
-    static std::unordered_map<TokenType, control_flow_fn> m_control_flow_fns;
-};
-
-constexpr int Parser::prehash(const char *str)
-{
-    int hash = 0;
-    while (*str)
+    // 以 TokenType 为下标的解析表，编译时生成；没有对应函数的项为空，没有优先级的项为 LOWEST
+    struct Rules
     {
-        hash = hash * 31 + *str++;
-    }
-    return hash;
-}
\ No newline at end of file
+        prefix_parse_fn prefix[TOKEN_TYPES] = {};
+        infix_parse_fn infix[TOKEN_TYPES] = {};
+        control_flow_fn control_flow[TOKEN_TYPES] = {};
+        int precedence[TOKEN_TYPES] = {}; // 运算符的优先级
+    };
+    static constexpr Rules make_rules();
+    static const Rules m_rules;
+};
@@ -2,10 +2,15 @@
 
 void Parser::parse_program(std::vector<Token> &tokens)
 {
-    new_sentence(tokens.begin(), tokens.end());
+    parse_program(tokens.begin(), tokens.end());
+}
+
+void Parser::parse_program(std::vector<Token>::iterator begin, std::vector<Token>::iterator end)
+{
+    new_sentence(begin, end);
     while (m_curr.type != TokenType::EOF_TOKEN && m_curr.type != TokenType::SEMICOLON && m_curr.type != TokenType::RIGHT_BRACE) // 解析程序
     {
-        std::shared_ptr<Statement> stmt = parse_statement();
+        NodeRef<Statement> stmt = parse_statement();
         if (stmt == nullptr)
         {
             return;
@@ -14,14 +19,12 @@ void Parser::parse_program(std::vector<Token> &tokens)
         if (stmt.get()->m_type != Node::Type::NODE_COMMENT && errors().empty()) // 如果指针有效
         {
             if (stmt->type() == Node::NODE_FUNCTION)
-                m_program->m_statements.push_back(std::dynamic_pointer_cast<Function>(stmt));
+                m_program->m_statements.push_back(dynamic_node_cast<Function>(stmt));
             else
                 m_program->m_statements.push_back(stmt);
         }
         if (m_curr.type != TokenType::SEMICOLON)
             next_token();
     }
-    m_program->identifier_map = &identifier_map;
-    m_program->function_map = &function_map;
     m_errors.clear();
 }
@@ -1,12 +1,12 @@
 #include "parser.h"
 
-std::shared_ptr<Statement> Parser::parse_statement_block()
+NodeRef<Statement> Parser::parse_statement_block()
 {
-    std::shared_ptr<StatementBlock> ele(new StatementBlock());
+    auto ele = make_node<StatementBlock>();
     while (m_curr.type != TokenType::EOF_TOKEN && m_peek.type != TokenType::RIGHT_BRACE) // 解析代码块
     {
         next_token();
-        std::shared_ptr<Statement> stmt = parse_statement();
+        NodeRef<Statement> stmt = parse_statement();
         if (stmt == nullptr) // pass comment
         {
             return nullptr;
@@ -20,18 +20,18 @@ std::shared_ptr<Statement> Parser::parse_statement_block()
     return ele;
 }
 
-std::shared_ptr<Statement> Parser::parse_statement()
+NodeRef<Statement> Parser::parse_statement()
 {
     if (m_curr.type == TokenType::HASH)
     {
-        return std::make_shared<Comment>();
+        return make_node<Comment>();
     }
-    auto it = m_control_flow_fns.find(m_curr.type);
-    if (it == m_control_flow_fns.end())
+    auto control_flow = m_rules.control_flow[m_curr.type];
+    if (!control_flow)
     {
         return parse_expression_statement();
     }
-    std::shared_ptr<Statement> ele = (this->*(it->second))();
+    NodeRef<Statement> ele = (this->*control_flow)();
     return ele;
     /*if (m_curr.type == TokenType::RETURN)
     {
@@ -55,10 +55,9 @@ std::shared_ptr<Statement> Parser::parse_statement()
     //}
 }
 
-std::shared_ptr<ExpressionStatement> Parser::parse_expression_statement()
+NodeRef<ExpressionStatement> Parser::parse_expression_statement()
 {
-    std::shared_ptr<ExpressionStatement> s(new ExpressionStatement);
-    s->m_token = m_curr;
+    auto s = make_node<ExpressionStatement>();
     s->m_expression = parse_expression(Precedence::LOWEST);
     if (peek_token_is(TokenType::SEMICOLON)) // while->if暂定
     {
@@ -67,10 +66,9 @@ std::shared_ptr<ExpressionStatement> Parser::parse_expression_statement()
     return s;
 }
 
-std::shared_ptr<Statement> Parser::parse_while_statement()
+NodeRef<Statement> Parser::parse_while_statement()
 {
-    std::shared_ptr<WhileStatement> ele(new WhileStatement());
-    ele->m_token = m_curr;
+    auto ele = make_node<WhileStatement>();
     next_token();
     ele->m_expression = parse_expression(LOWEST);
     next_token();
@@ -78,10 +76,9 @@ std::shared_ptr<Statement> Parser::parse_while_statement()
     return ele;
 }
 
-std::shared_ptr<Statement> Parser::parse_if_statement()
+NodeRef<Statement> Parser::parse_if_statement()
 {
-    std::shared_ptr<IfStatement> ele(new IfStatement());
-    ele->m_token = m_curr;
+    auto ele = make_node<IfStatement>();
     next_token();
     ele->m_expression = parse_expression(LOWEST);
     next_token();
@@ -98,27 +95,27 @@ std::shared_ptr<Statement> Parser::parse_if_statement()
     return ele;
 }
 
-std::shared_ptr<Statement> Parser::parse_break_statement()
+NodeRef<Statement> Parser::parse_break_statement()
 {
-    std::shared_ptr<BreakStatement> ele(new BreakStatement());
+    auto ele = make_node<BreakStatement>();
     next_token();
     return ele;
 }
 
-std::shared_ptr<Statement> Parser::parse_continue_statement()
+NodeRef<Statement> Parser::parse_continue_statement()
 {
-    std::shared_ptr<ContinueStatement> ele(new ContinueStatement());
+    auto ele = make_node<ContinueStatement>();
     next_token();
     return ele;
 }
 
-std::shared_ptr<Statement> Parser::parse_function_declaration()
+NodeRef<Statement> Parser::parse_function_declaration()
 {
-    std::shared_ptr<Function> fn(new Function());
+    auto fn = make_node<Function>();
+    fn->m_arena = m_program->m_arena.get();
     next_token();
-    std::shared_ptr<Identifier> ele(new Identifier());
-    ele->m_token = this->m_curr;
-    ele->m_name = hash(m_curr.literalToString()); // 转换
+    auto ele = make_node<Identifier>();
+    ele->m_name = m_curr.id; // 词法分析时已驻留
     fn->m_func = ele;
     next_token();
     if (m_curr.type == TokenType::LEFT_PAREN)
@@ -126,12 +123,12 @@ std::shared_ptr<Statement> Parser::parse_function_declaration()
         while (m_peek.type != TokenType::RIGHT_PAREN)
         {
             next_token();
-            auto arg = parse_identifier();
-            if (arg->m_token.type != TokenType::IDENTIFIER)
+            if (m_curr.type != TokenType::IDENTIFIER)
             {
                 throw std::invalid_argument("Parser::Invalid Function Argument List");
             }
-            fn->m_initial_list.push_back(std::dynamic_pointer_cast<Identifier>(arg));
+            auto arg = parse_identifier();
+            fn->m_initial_list.push_back(dynamic_node_cast<Identifier>(arg));
             if (m_peek.type == TokenType::COMMA)
                 next_token();
         }
@@ -142,14 +139,14 @@ std::shared_ptr<Statement> Parser::parse_function_declaration()
     {
         throw std::invalid_argument("Parser::Invalid Function Declaration");
     }
-    std::shared_ptr<StatementBlock> stmt = std::dynamic_pointer_cast<StatementBlock>(parse_statement_block());
+    NodeRef<StatementBlock> stmt = dynamic_node_cast<StatementBlock>(parse_statement_block());
     if (stmt)
         fn->m_statement = stmt;
     next_token();
 
     // while (m_curr.type != TokenType::SEMICOLON && m_curr.type != TokenType::RIGHT_BRACE)
     // {
-    //     std::shared_ptr<Statement> stmt = parse_statement();
+    //     NodeRef<Statement> stmt = parse_statement();
     //     if (stmt.get()->m_type != Node::Type::NODE_COMMENT && errors().empty()) // 如果指针有效
     //     {
     //         fn->m_statements.push_back(stmt);
@@ -160,9 +157,9 @@ std::shared_ptr<Statement> Parser::parse_function_declaration()
     return fn;
 }
 
-std::shared_ptr<Statement> Parser::parse_return_statement()
+NodeRef<Statement> Parser::parse_return_statement()
 {
-    std::shared_ptr<ReturnStatement> ele(new ReturnStatement);
+    auto ele = make_node<ReturnStatement>();
     next_token();
     ele->m_expression_statement = parse_expression_statement();
     return ele;
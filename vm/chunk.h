@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "../object/object.h"
+#include "../ast/node.h"
+
+// 字节码指令，操作数紧跟在指令之后
+enum OpCode : int
+{
+    OP_CONSTANT = 0, // [k]        压入常量 k
+    OP_NIL,          //            压入空值
+    OP_POP,          //            弹出栈顶
+    OP_GET_VAR,      // [name]     读变量（沿作用域链查找）
+    OP_SET_VAR,      // [name]     赋值，保留栈顶
+    OP_INC_VAR,      // [name]     ++name
+    OP_GET_LOCAL,    // [depth, slot] 读已解析的变量
+    OP_SET_LOCAL,    // [depth, slot] 给已解析的变量赋值，保留栈顶
+    OP_INC_LOCAL,    // [depth, slot] ++已解析的变量
+    OP_GET_INDEX,    //            array[index]
+    OP_SET_INDEX,    //            array[index] = value
+
+    // 二元运算
+    OP_ADD,         // +
+    OP_SUB,         // -
+    OP_MUL,         // *
+    OP_DIV,         // /
+    OP_FLOOR_DIV,   // //
+    OP_POW,         // **
+    OP_MOD,         // %
+    OP_EQUAL,       // ==
+    OP_NOT_EQUAL,   // !=
+    OP_LESS,        // <
+    OP_GREATER,     // >
+    OP_LESS_EQUAL,  // <=
+    OP_GREATER_EQUAL, // >=
+    OP_BINARY,      // [op]       其余中缀运算（位运算、逻辑运算、小数点）
+
+    // 前缀运算
+    OP_NEGATE, //            -x
+    OP_PREFIX, // [op]       其余前缀运算
+
+    // 控制流
+    OP_JUMP,          // [target]
+    OP_JUMP_IF_FALSE, // [target] 弹出条件
+    OP_ENTER_SCOPE,   // [k]      以布局 k 进入语句块作用域
+    OP_LEAVE_SCOPE,   // [n]      离开 n 层作用域
+
+    // 其他
+    OP_ARRAY,    // [n]          用栈顶 n 个值构造数组
+    OP_CALL,     // [name, argc] 函数调用
+    OP_FUNCTION, // [k]          声明函数 k
+    OP_RETURN,   //              返回栈顶
+
+    // 超级指令：把常见的语句和条件融合为一条指令，操作数见 OperandKind
+    OP_INCREMENT,       // [var]               ++var 作为语句（不压栈）
+    OP_ADD_CONSTANT,    // [var, k]            var = var + k 作为语句
+    OP_JUMP_IF_NOT_CMP, // [op, a, b, target]  a op b 不成立时跳转
+    OP_INDEX_CMP,       // [op, array, idx, b] 压入 array[idx] op b
+
+    OP_TAIL_CALL, // [name, argc] return 处的函数调用，复用当前帧；不是用户函数时同 OP_CALL，之后紧跟 OP_RETURN
+};
+
+// 超级指令的一个操作数占两个字：[depth, slot] 为已解析的变量，其余见下
+enum OperandKind : int
+{
+    OPERAND_NAME = -1,     // [OPERAND_NAME, name]   按名字查找的变量
+    OPERAND_CONSTANT = -2, // [OPERAND_CONSTANT, k]  常量 k
+};
+
+// 一段编译后的字节码
+class Chunk
+{
+public:
+    int emit(int word)
+    {
+        m_code.push_back(word);
+        return (int)m_code.size() - 1;
+    }
+    int add_constant(const Value &value)
+    {
+        m_constants.push_back(value);
+        return (int)m_constants.size() - 1;
+    }
+    int add_function(const NodeRef<Node> &node)
+    {
+        m_functions.push_back(node);
+        return (int)m_functions.size() - 1;
+    }
+    int add_layout(const std::vector<int> *layout)
+    {
+        m_layouts.push_back(layout);
+        return (int)m_layouts.size() - 1;
+    }
+
+public:
+    std::vector<int> m_code;                          // 指令流
+    std::vector<Value> m_constants;                   // 常量池
+    std::vector<NodeRef<Node>> m_functions;           // 函数声明节点（与持有本 Chunk 的程序或函数节点同属一个分配区）
+    std::vector<const std::vector<int> *> m_layouts;  // 语句块作用域的槽位布局
+};
@@ -0,0 +1,467 @@
+#include "compiler.h"
+
+std::shared_ptr<Chunk> Compiler::compile_program(const std::shared_ptr<Program> &program)
+{
+    if (program->statements().empty())
+        throw std::runtime_error("Compiler::compile_program: empty program");
+    m_chunk = std::make_shared<Chunk>();
+    m_loops.clear();
+    m_scope_depth = 0;
+    m_in_function = false;
+    compile_statement(*(--program->statements().end()), true);
+    m_chunk->emit(OP_RETURN);
+    return m_chunk;
+}
+
+std::shared_ptr<Chunk> Compiler::compile_function(const NodeRef<Node> &function)
+{
+    m_chunk = std::make_shared<Chunk>();
+    m_loops.clear();
+    m_scope_depth = 0;
+    m_in_function = true;
+    for (auto &stat : function->statement()->statements())
+    {
+        compile_statement(stat, false);
+    }
+    m_chunk->emit(OP_NIL);
+    m_chunk->emit(OP_RETURN);
+    return m_chunk;
+}
+
+void Compiler::compile_statement(const NodeRef<Node> &node, bool keep)
+{
+    switch (node->type())
+    {
+    case Node::NODE_EXPRESSION_STATEMENT:
+    {
+        if (!keep && compile_fused_statement(node->expression()))
+            return;
+        compile_expression(node->expression());
+        if (!keep)
+            m_chunk->emit(OP_POP);
+        return;
+    }
+    case Node::NODE_STATEMENTBLOCK:
+    {
+        compile_block(node, keep);
+        return;
+    }
+    case Node::NODE_IFSTATEMENT:
+    {
+        compile_if(node, keep);
+        return;
+    }
+    case Node::NODE_WHILESTATEMENT:
+    {
+        compile_while(node, keep);
+        return;
+    }
+    case Node::NODE_BREAKSTATEMENT:
+    {
+        compile_jump_out(true);
+        return;
+    }
+    case Node::NODE_CONTINUESTATEMENT:
+    {
+        compile_jump_out(false);
+        return;
+    }
+    case Node::NODE_FUNCTION:
+    {
+        m_chunk->emit(OP_FUNCTION);
+        m_chunk->emit(m_chunk->add_function(node));
+        if (keep)
+            m_chunk->emit(OP_NIL);
+        return;
+    }
+    case Node::NODE_RETURNSTATEMENT:
+    {
+        auto &value = node->expression_statement()->expression();
+        if (m_in_function && value->type() == Node::NODE_FUNCTION_IDENTIFIER)
+        {
+            for (auto &arg : value->initial_list())
+            {
+                compile_expression(arg);
+            }
+            m_chunk->emit(OP_TAIL_CALL);
+            m_chunk->emit(value->m_name);
+            m_chunk->emit((int)value->initial_list().size());
+            m_chunk->emit(OP_RETURN);
+            return;
+        }
+        compile_expression(value);
+        m_chunk->emit(OP_RETURN);
+        return;
+    }
+    default:
+        // 表达式直接作为语句
+        if (!keep && compile_fused_statement(node))
+            return;
+        compile_expression(node);
+        if (!keep)
+            m_chunk->emit(OP_POP);
+    }
+}
+
+void Compiler::compile_block(const NodeRef<Node> &node, bool keep)
+{
+    auto &stmts = node->statements();
+    m_chunk->emit(OP_ENTER_SCOPE);
+    m_chunk->emit(m_chunk->add_layout(&node->locals()));
+    m_scope_depth++;
+    for (size_t i = 0; i < stmts.size(); i++)
+    {
+        compile_statement(stmts[i], keep && i + 1 == stmts.size());
+    }
+    if (keep && stmts.empty())
+        m_chunk->emit(OP_NIL);
+    m_scope_depth--;
+    m_chunk->emit(OP_LEAVE_SCOPE);
+    m_chunk->emit(1);
+}
+
+void Compiler::compile_if(const NodeRef<Node> &node, bool keep)
+{
+    int to_else = compile_condition(node->expression());
+    compile_statement(node->true_statement(), keep);
+    int to_end = emit_jump(OP_JUMP);
+    patch_jump(to_else);
+    if (node->false_statement())
+        compile_statement(node->false_statement(), keep);
+    else if (keep)
+        m_chunk->emit(OP_NIL);
+    patch_jump(to_end);
+}
+
+void Compiler::compile_while(const NodeRef<Node> &node, bool keep)
+{
+    m_loops.push_back({(int)m_chunk->m_code.size(), m_scope_depth, {}});
+    int to_end = compile_condition(node->expression());
+    compile_statement(node->cycle_statement(), false);
+    m_chunk->emit(OP_JUMP);
+    m_chunk->emit(m_loops.back().start);
+    patch_jump(to_end);
+    for (int at : m_loops.back().breaks)
+    {
+        patch_jump(at);
+    }
+    m_loops.pop_back();
+    if (keep)
+        m_chunk->emit(OP_NIL);
+}
+
+void Compiler::compile_jump_out(bool is_break)
+{
+    // 循环外的 break/continue 结束当前函数（或程序）
+    if (m_loops.empty())
+    {
+        m_chunk->emit(OP_NIL);
+        m_chunk->emit(OP_RETURN);
+        return;
+    }
+    Loop &loop = m_loops.back();
+    if (m_scope_depth > loop.scope_depth)
+    {
+        m_chunk->emit(OP_LEAVE_SCOPE);
+        m_chunk->emit(m_scope_depth - loop.scope_depth);
+    }
+    if (is_break)
+    {
+        loop.breaks.push_back(emit_jump(OP_JUMP));
+    }
+    else
+    {
+        m_chunk->emit(OP_JUMP);
+        m_chunk->emit(loop.start);
+    }
+}
+
+void Compiler::compile_expression(const NodeRef<Node> &node)
+{
+    switch (node->type())
+    {
+    case Node::NODE_INTEGER:
+    {
+        m_chunk->emit(OP_CONSTANT);
+        m_chunk->emit(m_chunk->add_constant(Value::integer(node->m_value)));
+        return;
+    }
+    case Node::NODE_BOOLEAN:
+    {
+        m_chunk->emit(OP_CONSTANT);
+        m_chunk->emit(m_chunk->add_constant(Value::boolean(node->m_bool)));
+        return;
+    }
+    case Node::NODE_STRING:
+    {
+        m_chunk->emit(OP_CONSTANT);
+        m_chunk->emit(m_chunk->add_constant(make_object<Ob_String>(node->string())));
+        return;
+    }
+    case Node::NODE_FRACTION:
+    {
+        m_chunk->emit(OP_CONSTANT);
+        m_chunk->emit(m_chunk->add_constant(Ob_Fraction::make(node->m_value, node->den())));
+        return;
+    }
+    case Node::NODE_IDENTIFIER:
+    {
+        emit_variable(OP_GET_VAR, OP_GET_LOCAL, node);
+        return;
+    }
+    case Node::NODE_INFIX:
+    {
+        compile_infix(node);
+        return;
+    }
+    case Node::NODE_PREFIX:
+    {
+        compile_prefix(node);
+        return;
+    }
+    case Node::NODE_FUNCTION_IDENTIFIER:
+    {
+        for (auto &arg : node->initial_list())
+        {
+            compile_expression(arg);
+        }
+        m_chunk->emit(OP_CALL);
+        m_chunk->emit(node->m_name);
+        m_chunk->emit((int)node->initial_list().size());
+        return;
+    }
+    case Node::NODE_ARRAY:
+    {
+        auto &elements = static_node_cast<Array>(node)->m_array;
+        for (auto &ele : elements)
+        {
+            compile_expression(ele);
+        }
+        m_chunk->emit(OP_ARRAY);
+        m_chunk->emit((int)elements.size());
+        return;
+    }
+    default:
+        throw std::invalid_argument("Compiler: node type error: " + Node::m_names[node->type()]);
+    }
+}
+
+void Compiler::compile_infix(const NodeRef<Node> &node)
+{
+    if (node->m_operator == TokenType::EQUAL)
+    {
+        if (node->m_left->type() == Node::NODE_IDENTIFIER)
+        {
+            compile_expression(node->m_right);
+            emit_variable(OP_SET_VAR, OP_SET_LOCAL, node->m_left);
+            return;
+        }
+        if (node->m_left->m_operator == TokenType::LEFT_BRACKET)
+        {
+            compile_expression(node->m_left->m_left);
+            compile_expression(node->m_left->m_right);
+            compile_expression(node->m_right);
+            m_chunk->emit(OP_SET_INDEX);
+            return;
+        }
+        throw std::runtime_error("Compiler::compile_infix: not an identifier: ");
+    }
+
+    // array[idx] op b
+    auto &left = node->m_left;
+    if (is_comparison(node->m_operator) && left->type() == Node::NODE_INFIX &&
+        left->m_operator == TokenType::LEFT_BRACKET && is_operand(left->m_left) && is_operand(left->m_right) &&
+        is_operand(node->m_right))
+    {
+        m_chunk->emit(OP_INDEX_CMP);
+        m_chunk->emit(node->m_operator);
+        emit_operand(left->m_left);
+        emit_operand(left->m_right);
+        emit_operand(node->m_right);
+        return;
+    }
+
+    compile_expression(node->m_left);
+    compile_expression(node->m_right);
+    switch (node->m_operator)
+    {
+    case TokenType::LEFT_BRACKET:
+        m_chunk->emit(OP_GET_INDEX);
+        return;
+    case TokenType::PLUS:
+        m_chunk->emit(OP_ADD);
+        return;
+    case TokenType::MINUS:
+        m_chunk->emit(OP_SUB);
+        return;
+    case TokenType::STAR:
+        m_chunk->emit(OP_MUL);
+        return;
+    case TokenType::SLASH:
+        m_chunk->emit(OP_DIV);
+        return;
+    case TokenType::SLASH_SLASH:
+        m_chunk->emit(OP_FLOOR_DIV);
+        return;
+    case TokenType::STAR_STAR:
+        m_chunk->emit(OP_POW);
+        return;
+    case TokenType::PERCENT:
+        m_chunk->emit(OP_MOD);
+        return;
+    case TokenType::EQUAL_EQUAL:
+        m_chunk->emit(OP_EQUAL);
+        return;
+    case TokenType::BANG_EQUAL:
+        m_chunk->emit(OP_NOT_EQUAL);
+        return;
+    case TokenType::LESS:
+        m_chunk->emit(OP_LESS);
+        return;
+    case TokenType::GREATER:
+        m_chunk->emit(OP_GREATER);
+        return;
+    case TokenType::LESS_EQUAL:
+        m_chunk->emit(OP_LESS_EQUAL);
+        return;
+    case TokenType::GREATER_EQUAL:
+        m_chunk->emit(OP_GREATER_EQUAL);
+        return;
+    default:
+        m_chunk->emit(OP_BINARY);
+        m_chunk->emit(node->m_operator);
+    }
+}
+
+void Compiler::compile_prefix(const NodeRef<Node> &node)
+{
+    if (node->m_operator == TokenType::PLUS_PLUS && node->m_right->type() == Node::NODE_IDENTIFIER)
+    {
+        emit_variable(OP_INC_VAR, OP_INC_LOCAL, node->m_right);
+        return;
+    }
+    compile_expression(node->m_right);
+    if (node->m_operator == TokenType::MINUS)
+    {
+        m_chunk->emit(OP_NEGATE);
+        return;
+    }
+    m_chunk->emit(OP_PREFIX);
+    m_chunk->emit(node->m_operator);
+}
+
+int Compiler::compile_condition(const NodeRef<Node> &node)
+{
+    // a op b，两边都是变量或常量时比较和跳转合为一条指令
+    if (node->type() == Node::NODE_INFIX && is_comparison(node->m_operator) &&
+        is_operand(node->m_left) && is_operand(node->m_right))
+    {
+        m_chunk->emit(OP_JUMP_IF_NOT_CMP);
+        m_chunk->emit(node->m_operator);
+        emit_operand(node->m_left);
+        emit_operand(node->m_right);
+        return m_chunk->emit(-1);
+    }
+    compile_expression(node);
+    return emit_jump(OP_JUMP_IF_FALSE);
+}
+
+bool Compiler::compile_fused_statement(const NodeRef<Node> &node)
+{
+    // ++x;
+    if (node->type() == Node::NODE_PREFIX && node->m_operator == TokenType::PLUS_PLUS &&
+        node->m_right->type() == Node::NODE_IDENTIFIER)
+    {
+        m_chunk->emit(OP_INCREMENT);
+        emit_operand(node->m_right);
+        return true;
+    }
+
+    // x = x + k;
+    if (node->type() != Node::NODE_INFIX || node->m_operator != TokenType::EQUAL)
+        return false;
+    auto &target = node->m_left;
+    auto &value = node->m_right;
+    if (target->type() != Node::NODE_IDENTIFIER || value->type() != Node::NODE_INFIX ||
+        value->m_operator != TokenType::PLUS || value->m_right->type() != Node::NODE_INTEGER)
+        return false;
+    auto &source = value->m_left;
+    // 读和写必须落在同一个变量上
+    if (source->type() != Node::NODE_IDENTIFIER || source->m_name != target->m_name ||
+        source->m_slot != target->m_slot || (target->m_slot >= 0 && source->m_depth != target->m_depth))
+        return false;
+    m_chunk->emit(OP_ADD_CONSTANT);
+    emit_operand(target);
+    emit_operand(value->m_right);
+    return true;
+}
+
+bool Compiler::is_operand(const NodeRef<Node> &node)
+{
+    auto type = node->type();
+    return type == Node::NODE_IDENTIFIER || type == Node::NODE_INTEGER || type == Node::NODE_BOOLEAN;
+}
+
+bool Compiler::is_comparison(TokenType op)
+{
+    return op == TokenType::EQUAL_EQUAL || op == TokenType::BANG_EQUAL || op == TokenType::LESS ||
+           op == TokenType::GREATER || op == TokenType::LESS_EQUAL || op == TokenType::GREATER_EQUAL;
+}
+
+void Compiler::emit_operand(const NodeRef<Node> &node)
+{
+    switch (node->type())
+    {
+    case Node::NODE_IDENTIFIER:
+        if (node->m_slot >= 0)
+        {
+            m_chunk->emit(node->m_depth);
+            m_chunk->emit(node->m_slot);
+        }
+        else
+        {
+            m_chunk->emit(OPERAND_NAME);
+            m_chunk->emit(node->m_name);
+        }
+        return;
+    case Node::NODE_INTEGER:
+        m_chunk->emit(OPERAND_CONSTANT);
+        m_chunk->emit(m_chunk->add_constant(Value::integer(node->m_value)));
+        return;
+    case Node::NODE_BOOLEAN:
+        m_chunk->emit(OPERAND_CONSTANT);
+        m_chunk->emit(m_chunk->add_constant(Value::boolean(node->m_bool)));
+        return;
+    default:
+        throw std::invalid_argument("Compiler::emit_operand: node type error: " + Node::m_names[node->type()]);
+    }
+}
+
+void Compiler::emit_variable(OpCode by_name, OpCode by_slot, const NodeRef<Node> &ident)
+{
+    if (ident->m_slot >= 0)
+    {
+        m_chunk->emit(by_slot);
+        m_chunk->emit(ident->m_depth);
+        m_chunk->emit(ident->m_slot);
+        return;
+    }
+    m_chunk->emit(by_name);
+    m_chunk->emit(ident->m_name);
+}
+
+int Compiler::emit_jump(OpCode op)
+{
+    m_chunk->emit(op);
+    return m_chunk->emit(-1);
+}
+
+void Compiler::patch_jump(int at)
+{
+    patch_jump(at, (int)m_chunk->m_code.size());
+}
+
+void Compiler::patch_jump(int at, int target)
+{
+    m_chunk->m_code[at] = target;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "chunk.h"
+#include "../ast/node.h"
+#include "../ast/statement.h"
+#include "../ast/infix.h"
+
+// 将 AST 降为字节码
+class Compiler
+{
+public:
+    Compiler() {}
+    ~Compiler() {}
+
+    std::shared_ptr<Chunk> compile_program(const std::shared_ptr<Program> &program); // 编译程序的最后一条语句
+    std::shared_ptr<Chunk> compile_function(const NodeRef<Node> &function);          // 编译函数体
+
+private:
+    struct Loop
+    {
+        int start;               // 条件判断处
+        int scope_depth;         // 进入循环时的作用域深度
+        std::vector<int> breaks; // 待回填的 break 跳转
+    };
+
+    void compile_statement(const NodeRef<Node> &node, bool keep); // keep: 是否在栈上留下语句的值
+    void compile_expression(const NodeRef<Node> &node);
+    void compile_block(const NodeRef<Node> &node, bool keep);
+    void emit_variable(OpCode by_name, OpCode by_slot, const NodeRef<Node> &ident); // 按解析结果选择指令
+    void compile_if(const NodeRef<Node> &node, bool keep);
+    void compile_while(const NodeRef<Node> &node, bool keep);
+    void compile_jump_out(bool is_break); // break / continue
+    void compile_infix(const NodeRef<Node> &node);
+    void compile_prefix(const NodeRef<Node> &node);
+    int compile_condition(const NodeRef<Node> &node);              // 编译条件，返回不成立时跳转的待回填位置
+    bool compile_fused_statement(const NodeRef<Node> &node); // 不保留值的语句能否用超级指令
+
+    static bool is_operand(const NodeRef<Node> &node);           // 变量或整数、布尔常量
+    static bool is_comparison(TokenType op);
+    void emit_operand(const NodeRef<Node> &node);
+
+    int emit_jump(OpCode op);            // 返回待回填的位置
+    void patch_jump(int at);             // 回填为当前位置
+    void patch_jump(int at, int target); // 回填为指定位置
+
+private:
+    std::shared_ptr<Chunk> m_chunk;
+    std::vector<Loop> m_loops;
+    int m_scope_depth = 0;
+    bool m_in_function = false; // 正在编译函数体（return 处的调用可以作为尾调用）
+};
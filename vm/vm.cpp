@@ -0,0 +1,664 @@
+#include "vm.h"
+#include "../parser/parser.h"
+
+// 指令分派：编译器支持标签地址（GCC/Clang）时用 computed goto 直接跳到下一条指令的处理代码，
+// 每条指令末尾各有一个间接跳转，分支预测更准；否则退回 switch
+#ifdef EWHU_COMPUTED_GOTO
+#define VM_DISPATCH VM_NEXT;
+#define VM_CASE(op) L_##op:
+#define VM_NEXT goto *dispatch_table[code[ip++]]
+#else
+#define VM_DISPATCH  \
+    while (true)     \
+        switch (code[ip++])
+#define VM_CASE(op) case op:
+#define VM_NEXT break
+#endif
+
+std::string VM::fused_report()
+{
+    static const char *names[] = {"increment", "add_constant", "jump_if_not_cmp", "index_cmp"};
+    std::string report;
+    for (int i = 0; i <= OP_INDEX_CMP - OP_INCREMENT; i++)
+    {
+        if (i > 0)
+            report += ", ";
+        report += std::string(names[i]) + "=" + std::to_string(fired[i]);
+    }
+    return report;
+}
+
+const char *VM::dispatch_mode()
+{
+#ifdef EWHU_COMPUTED_GOTO
+    return "computed goto";
+#else
+    return "switch";
+#endif
+}
+
+Value VM::run_program(const std::shared_ptr<Program> &program, Scope &global_scp)
+{
+    m_folder.fold_program(program, m_evaluator);
+    m_resolver.resolve_program(program, global_scp);
+    auto chunk = m_compiler.compile_program(program);
+    m_global = &global_scp;
+    m_scope = m_global;
+    m_frames.push_back({chunk.get(), 0, 0, 0});
+    try
+    {
+        return run();
+    }
+    catch (...)
+    {
+        reset();
+        throw;
+    }
+}
+
+Value VM::run()
+{
+    Frame *frame = &m_frames.back();
+    const int *code = frame->chunk->m_code.data();
+    int ip = frame->ip;
+
+#ifdef EWHU_COMPUTED_GOTO
+    // 顺序必须与 OpCode 一致
+    static void *const dispatch_table[] = {
+        &&L_OP_CONSTANT, &&L_OP_NIL, &&L_OP_POP, &&L_OP_GET_VAR, &&L_OP_SET_VAR, &&L_OP_INC_VAR,
+        &&L_OP_GET_LOCAL, &&L_OP_SET_LOCAL, &&L_OP_INC_LOCAL, &&L_OP_GET_INDEX, &&L_OP_SET_INDEX,
+        &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_FLOOR_DIV, &&L_OP_POW, &&L_OP_MOD,
+        &&L_OP_EQUAL, &&L_OP_NOT_EQUAL, &&L_OP_LESS, &&L_OP_GREATER, &&L_OP_LESS_EQUAL, &&L_OP_GREATER_EQUAL,
+        &&L_OP_BINARY, &&L_OP_NEGATE, &&L_OP_PREFIX,
+        &&L_OP_JUMP, &&L_OP_JUMP_IF_FALSE, &&L_OP_ENTER_SCOPE, &&L_OP_LEAVE_SCOPE,
+        &&L_OP_ARRAY, &&L_OP_CALL, &&L_OP_FUNCTION, &&L_OP_RETURN,
+        &&L_OP_INCREMENT, &&L_OP_ADD_CONSTANT, &&L_OP_JUMP_IF_NOT_CMP, &&L_OP_INDEX_CMP,
+        &&L_OP_TAIL_CALL};
+    static_assert(sizeof(dispatch_table) / sizeof(dispatch_table[0]) == OP_TAIL_CALL + 1,
+                  "dispatch_table must cover every OpCode");
+#endif
+
+    VM_DISPATCH
+    {
+    VM_CASE(OP_CONSTANT)
+    {
+        m_stack.push_back(frame->chunk->m_constants[code[ip++]]);
+        VM_NEXT;
+    }
+    VM_CASE(OP_NIL)
+    {
+        m_stack.emplace_back();
+        VM_NEXT;
+    }
+    VM_CASE(OP_POP)
+    {
+        m_stack.pop_back();
+        VM_NEXT;
+    }
+    VM_CASE(OP_GET_VAR)
+    {
+        int name = code[ip++];
+        auto var = m_scope->lookup(name);
+        if (var)
+        {
+            m_stack.push_back(*var);
+            VM_NEXT;
+        }
+        auto function = m_scope->function(name);
+        if (function)
+        {
+            m_stack.push_back(make_object<Ob_Funtion>(*function));
+            VM_NEXT;
+        }
+        throw std::runtime_error("VM::run: identifier '" + std::string(Intern::name(name)) + "' not found");
+    }
+    VM_CASE(OP_SET_VAR)
+    {
+        int name = code[ip++];
+        auto var = m_scope->lookup(name);
+        if (var)
+            *var = m_stack.back();
+        else
+            m_scope->define(name, m_stack.back());
+        VM_NEXT;
+    }
+    VM_CASE(OP_INC_VAR)
+    {
+        int name = code[ip++];
+        auto var = m_scope->lookup(name);
+        if (!var)
+            throw std::runtime_error("VM::run: identifier '" + std::string(Intern::name(name)) + "' not found");
+        *var = prefix(TokenType::PLUS_PLUS, *var);
+        m_stack.push_back(*var);
+        VM_NEXT;
+    }
+    VM_CASE(OP_GET_LOCAL)
+    {
+        Scope *scp = scope_at(code[ip]);
+        m_stack.push_back(scp->m_slots[code[ip + 1]]);
+        ip += 2;
+        VM_NEXT;
+    }
+    VM_CASE(OP_SET_LOCAL)
+    {
+        Scope *scp = scope_at(code[ip]);
+        scp->m_slots[code[ip + 1]] = m_stack.back();
+        ip += 2;
+        VM_NEXT;
+    }
+    VM_CASE(OP_INC_LOCAL)
+    {
+        auto &var = scope_at(code[ip])->m_slots[code[ip + 1]];
+        var = prefix(TokenType::PLUS_PLUS, var);
+        m_stack.push_back(var);
+        ip += 2;
+        VM_NEXT;
+    }
+    // computed goto 跳出作用域时不调用局部变量的析构函数，以下各指令直接在栈上操作，不持有 Value 局部变量
+    VM_CASE(OP_GET_INDEX)
+    {
+        auto &array = m_stack[m_stack.size() - 2];
+        array = index(array, m_stack.back());
+        m_stack.pop_back();
+        VM_NEXT;
+    }
+    VM_CASE(OP_SET_INDEX)
+    {
+        auto &array = m_stack[m_stack.size() - 3];
+        auto &idx = m_stack[m_stack.size() - 2];
+        index(array, idx);
+        array->array()[idx.m_int] = m_stack.back();
+        array = std::move(m_stack.back());
+        m_stack.resize(m_stack.size() - 2);
+        VM_NEXT;
+    }
+    VM_CASE(OP_ADD)
+    VM_CASE(OP_SUB)
+    VM_CASE(OP_MUL)
+    VM_CASE(OP_DIV)
+    VM_CASE(OP_FLOOR_DIV)
+    VM_CASE(OP_POW)
+    VM_CASE(OP_MOD)
+    VM_CASE(OP_EQUAL)
+    VM_CASE(OP_NOT_EQUAL)
+    VM_CASE(OP_LESS)
+    VM_CASE(OP_GREATER)
+    VM_CASE(OP_LESS_EQUAL)
+    VM_CASE(OP_GREATER_EQUAL)
+    {
+        static const TokenType ops[] = {TokenType::PLUS, TokenType::MINUS, TokenType::STAR, TokenType::SLASH,
+                                        TokenType::SLASH_SLASH, TokenType::STAR_STAR, TokenType::PERCENT,
+                                        TokenType::EQUAL_EQUAL, TokenType::BANG_EQUAL, TokenType::LESS,
+                                        TokenType::GREATER, TokenType::LESS_EQUAL, TokenType::GREATER_EQUAL};
+        auto &left = m_stack[m_stack.size() - 2];
+        left = binary(ops[code[ip - 1] - OP_ADD], left, m_stack.back());
+        m_stack.pop_back();
+        VM_NEXT;
+    }
+    VM_CASE(OP_BINARY)
+    {
+        auto op = (TokenType)code[ip++];
+        auto &left = m_stack[m_stack.size() - 2];
+        left = binary(op, left, m_stack.back());
+        m_stack.pop_back();
+        VM_NEXT;
+    }
+    VM_CASE(OP_NEGATE)
+    {
+        auto &right = m_stack.back();
+        right = prefix(TokenType::MINUS, right);
+        VM_NEXT;
+    }
+    VM_CASE(OP_PREFIX)
+    {
+        auto op = (TokenType)code[ip++];
+        auto &right = m_stack.back();
+        right = prefix(op, right);
+        VM_NEXT;
+    }
+    VM_CASE(OP_JUMP)
+    {
+        ip = code[ip];
+        VM_NEXT;
+    }
+    VM_CASE(OP_JUMP_IF_FALSE)
+    {
+        if (truthy(pop()))
+            ip++;
+        else
+            ip = code[ip];
+        VM_NEXT;
+    }
+    VM_CASE(OP_ENTER_SCOPE)
+    {
+        enter_scope(frame->chunk->m_layouts[code[ip++]]);
+        VM_NEXT;
+    }
+    VM_CASE(OP_LEAVE_SCOPE)
+    {
+        leave_scope(code[ip++]);
+        VM_NEXT;
+    }
+    VM_CASE(OP_ARRAY)
+    {
+        int n = code[ip++];
+        auto ary = make_object<Ob_Array>();
+        ary->array().assign(std::make_move_iterator(m_stack.end() - n), std::make_move_iterator(m_stack.end()));
+        m_stack.resize(m_stack.size() - n);
+        m_stack.push_back(std::move(ary)); // 移走后 ary 为空，不需要析构
+        VM_NEXT;
+    }
+    VM_CASE(OP_CALL)
+    {
+        int name = code[ip++];
+        int argc = code[ip++];
+        frame->ip = ip;
+        call(name, argc);
+        frame = &m_frames.back();
+        code = frame->chunk->m_code.data();
+        ip = frame->ip;
+        VM_NEXT;
+    }
+    VM_CASE(OP_FUNCTION)
+    {
+        auto &node = frame->chunk->m_functions[code[ip++]];
+        m_scope->declare(node->func()->m_name, node);
+        VM_NEXT;
+    }
+    VM_CASE(OP_RETURN)
+    {
+        // 返回值移到调用前的栈顶
+        if (m_stack.size() - 1 != frame->stack_base)
+            m_stack[frame->stack_base] = std::move(m_stack.back());
+        m_stack.resize(frame->stack_base + 1);
+        leave_scope(m_scopes.size() - frame->scope_base);
+        m_frames.pop_back();
+        if (m_frames.empty())
+            return pop();
+        frame = &m_frames.back();
+        code = frame->chunk->m_code.data();
+        ip = frame->ip;
+        VM_NEXT;
+    }
+    VM_CASE(OP_INCREMENT)
+    {
+        fired[OP_INCREMENT - OP_INCREMENT]++;
+        Value *var = variable(code + ip);
+        ip += 2;
+        long long next;
+        if (var->is_number() && !__builtin_add_overflow(var->m_int, 1, &next))
+            var->m_int = next;
+        else
+            *var = prefix(TokenType::PLUS_PLUS, *var);
+        VM_NEXT;
+    }
+    VM_CASE(OP_ADD_CONSTANT)
+    {
+        fired[OP_ADD_CONSTANT - OP_INCREMENT]++;
+        Value *var = variable(code + ip);
+        auto &k = frame->chunk->m_constants[code[ip + 3]];
+        ip += 4;
+        long long sum;
+        if (var->is_number() && !__builtin_add_overflow(var->m_int, k.m_int, &sum))
+            var->m_int = sum;
+        else
+            *var = binary(TokenType::PLUS, *var, k);
+        VM_NEXT;
+    }
+    VM_CASE(OP_JUMP_IF_NOT_CMP)
+    {
+        fired[OP_JUMP_IF_NOT_CMP - OP_INCREMENT]++;
+        auto op = (TokenType)code[ip];
+        auto &left = operand(frame->chunk, code + ip + 1);
+        auto &right = operand(frame->chunk, code + ip + 3);
+        if (compare(op, left, right))
+            ip += 6;
+        else
+            ip = code[ip + 5];
+        VM_NEXT;
+    }
+    VM_CASE(OP_INDEX_CMP)
+    {
+        fired[OP_INDEX_CMP - OP_INCREMENT]++;
+        auto op = (TokenType)code[ip];
+        auto &array = operand(frame->chunk, code + ip + 1);
+        auto &idx = operand(frame->chunk, code + ip + 3);
+        auto &right = operand(frame->chunk, code + ip + 5);
+        ip += 7;
+        index(array, idx);
+        m_stack.push_back(Value::boolean(compare(op, array->array()[idx.m_int], right)));
+        VM_NEXT;
+    }
+    VM_CASE(OP_TAIL_CALL)
+    {
+        int name = code[ip++];
+        int argc = code[ip++];
+        frame->ip = ip;
+        if (!tail_call(name, argc))
+            call(name, argc);
+        frame = &m_frames.back();
+        code = frame->chunk->m_code.data();
+        ip = frame->ip;
+        VM_NEXT;
+    }
+#ifndef EWHU_COMPUTED_GOTO
+    default:
+        throw std::runtime_error("VM::run: unknown opcode " + std::to_string(code[ip - 1]));
+#endif
+    }
+}
+
+void VM::call(int name, int argc)
+{
+    auto found = find_function(name);
+    if (!found)
+    {
+        auto result = call_builtin(name, argc);
+        m_stack.resize(m_stack.size() - argc);
+        m_stack.push_back(result);
+        return;
+    }
+
+    auto &function = *found;
+    if ((int)function->initial_list().size() != argc)
+        throw std::runtime_error("VM::call: function arguments not match");
+
+    // 参数已在调用者的栈上，移入新作用域
+    size_t base = m_stack.size() - argc;
+    m_frames.push_back({function_chunk(function), 0, base, m_scopes.size()});
+    enter_scope(&function->locals());
+    for (int i = 0; i < argc; i++)
+    {
+        m_scope->define(function->initial_list()[i]->m_name, m_stack[base + i]);
+    }
+    m_stack.resize(base);
+}
+
+bool VM::tail_call(int name, int argc)
+{
+    // 最外层帧是程序本身，没有可以复用的函数作用域
+    if (m_frames.size() < 2)
+        return false;
+    auto found = find_function(name);
+    if (!found)
+        return false;
+
+    auto function = *found;
+    if ((int)function->initial_list().size() != argc)
+        throw std::runtime_error("VM::call: function arguments not match");
+
+    // 语句块作用域并入函数作用域，再换成被调函数的布局
+    Frame &frame = m_frames.back();
+    Scope *frame_scope = &m_scopes[frame.scope_base];
+    m_scope->collapse_into(frame_scope);
+    leave_scope(m_scopes.size() - frame.scope_base - 1);
+    frame_scope->relayout(&function->locals());
+    size_t base = m_stack.size() - argc;
+    for (int i = 0; i < argc; i++)
+    {
+        frame_scope->define(function->initial_list()[i]->m_name, std::move(m_stack[base + i]));
+    }
+    m_stack.resize(frame.stack_base);
+    frame.chunk = function_chunk(function);
+    frame.ip = 0;
+    return true;
+}
+
+const std::shared_ptr<Node> *VM::find_function(int name)
+{
+    for (Scope *scp = m_scope; scp != nullptr; scp = scp->father)
+    {
+        auto function = scp->function(name);
+        if (function)
+            return function;
+    }
+    return nullptr;
+}
+
+Value VM::call_builtin(int name, int argc)
+{
+    int builtin = Builtins::find(name);
+    if (builtin < 0)
+        throw std::runtime_error("VM::call: function '" + std::string(Intern::name(name)) + "' not found");
+    auto &entry = Builtins::at(builtin);
+    if (argc != entry.arity)
+        throw std::invalid_argument(std::string("VM::call_builtin: function ") + entry.name + " arguments not match");
+    // 参数就在栈上，数组按引用共享，不需要另外取容器
+    return entry.native(m_evaluator, m_stack.data() + m_stack.size() - argc, *m_scope);
+}
+
+const Chunk *VM::function_chunk(const NodeRef<Node> &function)
+{
+    auto &chunk = static_cast<Function *>(function.get())->m_chunk;
+    if (!chunk)
+        chunk = m_compiler.compile_function(function);
+    return chunk.get();
+}
+
+Value VM::binary(TokenType op, const Value &left, const Value &right)
+{
+    if (!left || !right)
+        throw std::runtime_error("VM::binary: operand of " + TokenTypeToString[op] + " has no value");
+
+    if (left.is_number() && right.is_number())
+    {
+        long long l = left.m_int;
+        long long r = right.m_int;
+        long long v;
+        // 算术运算结果沿用左操作数的类型
+        auto same = [&left](long long v)
+        {
+            Value result = left;
+            result.m_int = v;
+            return result;
+        };
+        // 溢出及除零等少见情形跳出 switch，交给求值器
+        switch (op)
+        {
+        case TokenType::PLUS:
+            if (__builtin_add_overflow(l, r, &v))
+                break;
+            return same(v);
+        case TokenType::MINUS:
+            if (__builtin_sub_overflow(l, r, &v))
+                break;
+            return same(v);
+        case TokenType::STAR:
+            if (__builtin_mul_overflow(l, r, &v))
+                break;
+            return same(v);
+        case TokenType::SLASH:
+            if (r == 0)
+                break;
+            return Ob_Fraction::make(l, r);
+        case TokenType::SLASH_SLASH:
+            if (r == 0 || r == -1)
+                break;
+            return same(l / r);
+        case TokenType::STAR_STAR:
+            if (r < 0 || !BigInt::small_pow(l, r, v))
+                break;
+            return same(v);
+        case TokenType::PERCENT:
+            if (r == 0 || r == -1)
+                break;
+            return same(l % r);
+        case TokenType::DOT:
+            return Ob_Fraction::make(Rational::decimal(l, r));
+        case TokenType::EQUAL_EQUAL:
+            return Value::boolean(l == r);
+        case TokenType::BANG_EQUAL:
+            return Value::boolean(l != r);
+        case TokenType::LESS:
+            return Value::boolean(l < r);
+        case TokenType::GREATER:
+            return Value::boolean(l > r);
+        case TokenType::LESS_EQUAL:
+            return Value::boolean(l <= r);
+        case TokenType::GREATER_EQUAL:
+            return Value::boolean(l >= r);
+        case TokenType::SHL:
+            return same(l << r);
+        case TokenType::SHR:
+            return same(l >> r);
+        case TokenType::BIT_XOR:
+            return same(l ^ r);
+        case TokenType::BIT_AND:
+            return same(l & r);
+        case TokenType::BIT_OR:
+            return same(l | r);
+        case TokenType::XOR:
+            return Value::boolean(l ^ r);
+        case TokenType::AND:
+            return Value::boolean(l && r);
+        case TokenType::OR:
+            return Value::boolean(l || r);
+        default:
+            throw std::runtime_error("VM::binary unknown operation: " + left.name() + TokenTypeToString[op] + right.name());
+        }
+    }
+
+    // 其余类型组合交给求值器
+    return m_evaluator.eval_infix(op, left, right, *m_scope);
+}
+
+Value VM::prefix(TokenType op, const Value &right)
+{
+    if (!right)
+        throw std::runtime_error("VM::prefix: operand of " + TokenTypeToString[op] + " has no value");
+
+    switch (right.type())
+    {
+    case Object::OBJECT_INTEGER:
+    {
+        if (op == TokenType::PLUS)
+            return right;
+        long long v;
+        if (op == TokenType::MINUS && !__builtin_sub_overflow(0, right.m_int, &v))
+            return Value::integer(v);
+        if (op == TokenType::PLUS_PLUS && !__builtin_add_overflow(right.m_int, 1, &v))
+            return Value::integer(v);
+        return m_evaluator.eval_integer_prefix_expression(op, right);
+    }
+    case Object::OBJECT_BOOLEAN:
+    {
+        if (op == TokenType::PLUS_PLUS)
+        {
+            Value result = right;
+            result.m_int += 1;
+            return result;
+        }
+        return m_evaluator.eval_boolean_prefix_expression(op, right);
+    }
+    case Object::OBJECT_FRACTION:
+        return m_evaluator.eval_fraction_prefix_expression(op, right);
+    case Object::OBJECT_BIGINT:
+        return m_evaluator.eval_bigint_prefix_expression(op, right);
+    case Object::OBJECT_BIGFRACTION:
+        return m_evaluator.eval_bigfraction_prefix_expression(op, right);
+    default:
+        throw std::runtime_error("VM::prefix unknown type for prefix: " + right.name());
+    }
+}
+
+Value VM::index(const Value &array, const Value &idx)
+{
+    if (array.type() != Object::OBJECT_ARRAY)
+        throw std::runtime_error("VM::index: can not convert '" + array.name() + "' to Array");
+    if (!idx.is_number())
+        throw std::runtime_error("VM::index: index is not an Integer");
+    long long i = idx.m_int;
+    if (i < 0 || i >= (long long)array->array().size())
+        throw std::runtime_error("VM::index: index of " + std::to_string(i) + " out of range");
+    return array->array()[i];
+}
+
+bool VM::truthy(const Value &value)
+{
+    switch (value.type())
+    {
+    case Object::OBJECT_INTEGER:
+    case Object::OBJECT_BOOLEAN:
+        return value.m_int != 0;
+    case Object::OBJECT_FRACTION:
+        return Ob_Fraction::of(value).num != 0;
+    case Object::OBJECT_BIGINT:
+    case Object::OBJECT_BIGFRACTION:
+        return true; // 超出 long long 范围，不可能为 0
+    case Object::OBJECT_STRING:
+        return !value->string().empty();
+    case Object::OBJECT_ARRAY:
+        return !value->array().empty();
+    default:
+        return false;
+    }
+}
+
+bool VM::compare(TokenType op, const Value &left, const Value &right)
+{
+    if (left.is_number() && right.is_number())
+    {
+        switch (op)
+        {
+        case TokenType::EQUAL_EQUAL:
+            return left.m_int == right.m_int;
+        case TokenType::BANG_EQUAL:
+            return left.m_int != right.m_int;
+        case TokenType::LESS:
+            return left.m_int < right.m_int;
+        case TokenType::GREATER:
+            return left.m_int > right.m_int;
+        case TokenType::LESS_EQUAL:
+            return left.m_int <= right.m_int;
+        case TokenType::GREATER_EQUAL:
+            return left.m_int >= right.m_int;
+        default:
+            break;
+        }
+    }
+    return truthy(binary(op, left, right));
+}
+
+Value *VM::variable(const int *at)
+{
+    if (at[0] >= 0)
+        return &scope_at(at[0])->m_slots[at[1]];
+    auto var = m_scope->lookup(at[1]);
+    if (!var)
+        throw std::runtime_error("VM::run: identifier '" + std::string(Intern::name(at[1])) + "' not found");
+    return var;
+}
+
+const Value &VM::operand(const Chunk *chunk, const int *at)
+{
+    if (at[0] == OPERAND_CONSTANT)
+        return chunk->m_constants[at[1]];
+    return *variable(at);
+}
+
+Scope *VM::scope_at(int depth)
+{
+    int i = (int)m_scopes.size() - 1 - depth;
+    return i >= 0 ? &m_scopes[i] : m_global;
+}
+
+void VM::enter_scope(const std::vector<int> *layout)
+{
+    m_scopes.emplace_back(m_scope, layout);
+    m_scope = &m_scopes.back();
+}
+
+void VM::leave_scope(size_t n)
+{
+    // 作用域的槽位分配在 Scope::frames 中，需要从内向外逐个销毁
+    while (n-- > 0)
+        m_scopes.pop_back();
+    m_scope = m_scopes.empty() ? m_global : &m_scopes.back();
+}
+
+void VM::reset()
+{
+    m_stack.clear();
+    m_frames.clear();
+    leave_scope(m_scopes.size());
+}
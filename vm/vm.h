@@ -0,0 +1,73 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "chunk.h"
+#include "compiler.h"
+#include "../evaluator/evaluator.h"
+#include "../evaluator/scope.h"
+#include "../evaluator/resolver.h"
+
+// 基于栈的字节码虚拟机
+class VM
+{
+public:
+    VM() {}
+    ~VM() {}
+
+    Value run_program(const std::shared_ptr<Program> &program, Scope &global_scp); // 编译并执行程序的最后一条语句
+    static const char *dispatch_mode();                                              // 构建时选定的指令分派方式
+    static std::string fused_report();                                               // 各超级指令的执行次数
+
+private:
+    struct Frame
+    {
+        const Chunk *chunk;
+        int ip;            // 下一条指令
+        size_t stack_base; // 调用前的栈高度
+        size_t scope_base; // 调用前的作用域数量
+    };
+
+    Value run();                            // 执行到最外层帧返回
+    void call(int name, int argc);          // 调用用户函数或内置函数
+    bool tail_call(int name, int argc);     // 在当前帧中执行尾调用，不是用户函数时返回 false
+    const std::shared_ptr<Node> *find_function(int name); // 沿作用域链查找用户函数
+    Value call_builtin(int name, int argc); // 内置函数
+    const Chunk *function_chunk(const NodeRef<Node> &function); // 函数体的字节码（第一次调用时编译）
+
+    Value binary(TokenType op, const Value &left, const Value &right); // 二元运算
+    Value prefix(TokenType op, const Value &right);                    // 前缀运算
+    Value index(const Value &array, const Value &idx);
+    static bool truthy(const Value &value);
+    bool compare(TokenType op, const Value &left, const Value &right); // 比较运算的结果是否成立
+
+    Value *variable(const int *at);                           // 超级指令的变量操作数
+    const Value &operand(const Chunk *chunk, const int *at); // 超级指令的变量或常量操作数
+
+    Scope *scope_at(int depth); // 向外第 depth 层作用域
+    void enter_scope(const std::vector<int> *layout);
+    void leave_scope(size_t n);
+    void reset();
+
+    Value pop()
+    {
+        auto top = std::move(m_stack.back());
+        m_stack.pop_back();
+        return top;
+    }
+
+private:
+    Resolver m_resolver;
+    Folder m_folder;
+    Compiler m_compiler;
+    Evaluator m_evaluator; // 复用的求值器（eval 等内置函数）
+
+    std::vector<Value> m_stack;                   // 值栈
+    std::vector<Frame> m_frames;                  // 调用栈
+    std::deque<Scope> m_scopes; // 语句块与函数的作用域，两端增删时其余元素的地址不变
+    Scope *m_global = nullptr;
+    Scope *m_scope = nullptr; // 当前作用域
+
+    inline static long long fired[OP_INDEX_CMP - OP_INCREMENT + 1] = {}; // 各超级指令的执行次数
+};